@@ -0,0 +1,116 @@
+// Bump-pointer arena: owns every object allocated from it and frees them
+// all at once, either when destroyed or when reset.
+
+#ifndef ARENA_H_
+#define ARENA_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+class Arena
+{
+public:
+    explicit Arena(std::size_t _blockSize = 64 * 1024) : blockSize(_blockSize) {}
+    Arena(const Arena&) = delete;
+    Arena& operator = (const Arena&) = delete;
+
+    // Construct a T inside the arena.
+    // The destructor of T will never be called, so T must not need it.
+    template <typename T, typename... Args>
+    T* Make(Args&&... args)
+    {
+        static_assert(std::is_trivially_destructible<T>::value,
+                      "objects allocated in the arena are never destroyed");
+        void* p = Allocate(sizeof(T), alignof(T));
+        return new (p) T(std::forward<Args>(args)...);
+    }
+
+    // Copy the string inside the arena and return a view of the copy
+    std::string_view CopyString(std::string_view s)
+    {
+        char* p = static_cast<char*>(Allocate(s.size(), 1));
+        std::memcpy(p, s.data(), s.size());
+        return std::string_view(p, s.size());
+    }
+
+    void* Allocate(std::size_t size, std::size_t alignment)
+    {
+        std::size_t padding = (alignment - reinterpret_cast<std::uintptr_t>(ptr) % alignment) % alignment;
+        if (ptr == nullptr || padding + size > static_cast<std::size_t>(end - ptr))
+        {
+            NextBlock(size + alignment);
+            padding = (alignment - reinterpret_cast<std::uintptr_t>(ptr) % alignment) % alignment;
+        }
+        void* result = ptr + padding;
+        ptr += padding + size;
+        return result;
+    }
+
+    // Release all the objects at once.
+    // The memory blocks are kept, so that the next compilation
+    // unit can reuse them without allocating.
+    void Reset()
+    {
+        current = 0;
+        ptr = end = nullptr;
+        if (!blocks.empty())
+            SetBlock(0);
+    }
+
+    std::size_t Capacity() const
+    {
+        std::size_t result = 0;
+        for (const auto& b: blocks)
+            result += b.size;
+        return result;
+    }
+
+private:
+    struct Block
+    {
+        std::unique_ptr<char[]> data;
+        std::size_t size;
+    };
+
+    // move to a block with at least size bytes: one of those released
+    // by Reset, if any is big enough, or a new one
+    void NextBlock(std::size_t size)
+    {
+        const std::size_t next = blocks.empty() ? 0 : current + 1;
+        for (std::size_t i = next; i < blocks.size(); ++i)
+        {
+            if (blocks[i].size >= size)
+            {
+                std::swap(blocks[next], blocks[i]); // keep the used blocks contiguous
+                SetBlock(next);
+                return;
+            }
+        }
+        const std::size_t s = std::max(size, blockSize);
+        blocks.insert(blocks.begin() + next, Block{ std::unique_ptr<char[]>(new char[s]), s });
+        SetBlock(next);
+    }
+
+    void SetBlock(std::size_t index)
+    {
+        current = index;
+        ptr = blocks[index].data.get();
+        end = ptr + blocks[index].size;
+    }
+
+    const std::size_t blockSize;
+    std::vector<Block> blocks;
+    std::size_t current = 0;
+    char* ptr = nullptr;
+    char* end = nullptr;
+};
+
+#endif // ARENA_H_
@@ -0,0 +1,392 @@
+// Abstract syntax tree of dcc.
+// The nodes are allocated in an Arena, that owns the whole tree:
+// they hold only raw pointers to their children and never need destruction.
+
+#ifndef AST_H_
+#define AST_H_
+
+#include <cstdint>
+#include <limits>
+#include <ostream>
+#include <string_view>
+#include <vector>
+#include "arena.h"
+#include "strength.h"
+
+namespace AST
+{
+    enum class UnaryOperator { negation, bitwise_complement, logical_negation };
+    enum class BinaryOperator { addition, subtraction, multiplication, division };
+
+    // Compute the result of an operation on constants with the semantics
+    // of the generated code: 32 bit two's complement, wrapping on overflow.
+    inline std::int32_t Compute(UnaryOperator op, std::int32_t x)
+    {
+        switch (op)
+        {
+            case UnaryOperator::negation: return static_cast<std::int32_t>(0u - static_cast<std::uint32_t>(x));
+            case UnaryOperator::bitwise_complement: return ~x;
+            case UnaryOperator::logical_negation: return !x;
+        }
+        return 0; // can't reach this point
+    }
+
+    // Returns false if the result is undefined (division by zero or overflow
+    // of INT_MIN / -1): these are left to trap at run time.
+    inline bool Compute(BinaryOperator op, std::int32_t l, std::int32_t r, std::int32_t& result)
+    {
+        const auto ul = static_cast<std::uint32_t>(l);
+        const auto ur = static_cast<std::uint32_t>(r);
+        switch (op)
+        {
+            case BinaryOperator::addition: result = static_cast<std::int32_t>(ul + ur); return true;
+            case BinaryOperator::subtraction: result = static_cast<std::int32_t>(ul - ur); return true;
+            case BinaryOperator::multiplication: result = static_cast<std::int32_t>(ul * ur); return true;
+            case BinaryOperator::division:
+                if (r == 0 || (l == std::numeric_limits<std::int32_t>::min() && r == -1))
+                    return false;
+                result = l / r; // truncates toward zero, like idiv
+                return true;
+        }
+        return false; // can't reach this point
+    }
+
+    class IntLiteral;
+    class Return;
+    class UnaryOperation;
+    class BinaryOp;
+    class Function;
+
+    // Lets the passes that don't belong to the nodes (e.g., the backends)
+    // walk the tree.
+    class Visitor
+    {
+    public:
+        virtual void Visit(const IntLiteral& node) = 0;
+        virtual void Visit(const Return& node) = 0;
+        virtual void Visit(const UnaryOperation& node) = 0;
+        virtual void Visit(const BinaryOp& node) = 0;
+        virtual void Visit(const Function& node) = 0;
+    protected:
+        ~Visitor() = default;
+    };
+
+    class Node;
+
+    // Walks the tree of root depth first without recursion: the nodes waiting
+    // for their children are on an explicit stack, so, like in the parser,
+    // the depth of the tree is limited only by the memory.
+    // step(node, stage) is called on a node with stage 0, 1, ... until it
+    // returns nullptr: any other result is a child, walked before the next call.
+    template <typename Step>
+    void Walk(const Node& root, Step step)
+    {
+        struct Frame
+        {
+            const Node* node;
+            int stage;
+        };
+        std::vector<Frame> stack{ { &root, 0 } };
+        while (!stack.empty())
+        {
+            Frame& frame = stack.back();
+            const Node* child = step(*frame.node, frame.stage++);
+            if (child != nullptr)
+                stack.push_back({ child, 0 });
+            else
+                stack.pop_back();
+        }
+    }
+
+    // A visitor that walks the tree with Walk: Visit is called at each step
+    // of a node, reads Stage() and calls Then to walk a child before the next one.
+    class StepVisitor : public Visitor
+    {
+    protected:
+        void Walk(const Node& root);
+        int Stage() const { return stage; }
+        void Then(const Node& child) { next = &child; }
+        ~StepVisitor() = default;
+    private:
+        int stage = 0;
+        const Node* next = nullptr;
+    };
+
+    class Node
+    {
+    public:
+        virtual void Accept(Visitor& visitor) const = 0;
+        // Code of the stack machine, emitted a step at a time (see Walk).
+        virtual const Node* Emit(std::ostream& out, int stage) const = 0;
+        void Emit(std::ostream& out) const
+        {
+            AST::Walk(*this, [&out](const Node& node, int stage) { return node.Emit(out, stage); });
+        }
+        // Constant folding and algebraic simplification of the tree,
+        // without recursion: returns the node that replaces this one
+        // (possibly this one).
+        Node* Fold(Arena& arena);
+        // Folds this node, whose children are folded already.
+        virtual Node* FoldNode(Arena& arena) = 0;
+        // the slot of the child i, that Fold replaces with the folded one,
+        // nullptr after the last child
+        virtual Node** Child(std::size_t i) = 0;
+    protected:
+        ~Node() = default; // the arena releases the memory
+    };
+
+    inline void StepVisitor::Walk(const Node& root)
+    {
+        AST::Walk(root, [this](const Node& node, int s)
+        {
+            stage = s;
+            next = nullptr;
+            node.Accept(*this);
+            return next;
+        });
+    }
+
+    inline Node* Node::Fold(Arena& arena)
+    {
+        // the slot of a node whose children are being folded, and its next child
+        struct Frame
+        {
+            Node** slot;
+            std::size_t child;
+        };
+        Node* root = this;
+        std::vector<Frame> stack{ { &root, 0 } };
+        while (!stack.empty())
+        {
+            Frame& frame = stack.back();
+            Node* node = *frame.slot;
+            if (Node** child = node->Child(frame.child++))
+                stack.push_back({ child, 0 });
+            else
+            {
+                *frame.slot = node->FoldNode(arena);
+                stack.pop_back();
+            }
+        }
+        return root;
+    }
+
+    class IntLiteral : public Node
+    {
+    public:
+        explicit IntLiteral(std::int32_t _value) : value(_value) {}
+        void Accept(Visitor& visitor) const override { visitor.Visit(*this); }
+        const Node* Emit(std::ostream& out, int) const override
+        {
+            out << "movl $" << value << ", %eax\n";
+            return nullptr;
+        }
+        Node* FoldNode(Arena&) override { return this; }
+        Node** Child(std::size_t) override { return nullptr; }
+        std::int32_t Value() const { return value; }
+    private:
+        const std::int32_t value;
+    };
+
+    class Return : public Node
+    {
+    public:
+        explicit Return(Node* _exp) : exp(_exp) {}
+        const Node& Expression() const { return *exp; }
+        void Accept(Visitor& visitor) const override { visitor.Visit(*this); }
+        const Node* Emit(std::ostream& out, int stage) const override
+        {
+            if (stage == 0)
+                return exp;
+            out << "ret\n";
+            return nullptr;
+        }
+        Node* FoldNode(Arena&) override { return this; }
+        Node** Child(std::size_t i) override { return i == 0 ? &exp : nullptr; }
+    private:
+        Node* exp;
+    };
+
+    class UnaryOperation : public Node
+    {
+    public:
+        UnaryOperation(UnaryOperator op, Node* _innerExpression) :
+            operation(op), innerExpression(_innerExpression) {}
+        UnaryOperator Operation() const { return operation; }
+        const Node& Operand() const { return *innerExpression; }
+        void Accept(Visitor& visitor) const override { visitor.Visit(*this); }
+        const Node* Emit(std::ostream& out, int stage) const override
+        {
+            if (stage == 0)
+                return innerExpression;
+            switch (operation)
+            {
+                case UnaryOperator::negation:
+                    out << "neg %eax\n";
+                    break;
+                case UnaryOperator::bitwise_complement:
+                    out << "not %eax\n";
+                    break;
+                case UnaryOperator::logical_negation:
+                    out << "cmpl $0, %eax\n";
+                    out << "movl $0, %eax\n";
+                    out << "sete %al\n";
+                    break;
+            }
+            return nullptr;
+        }
+        Node* FoldNode(Arena& arena) override
+        {
+            if (auto literal = dynamic_cast<const IntLiteral*>(innerExpression))
+                return arena.Make<IntLiteral>(Compute(operation, literal->Value()));
+            auto inner = dynamic_cast<const UnaryOperation*>(innerExpression);
+            if (inner != nullptr && inner->operation == operation)
+            {
+                switch (operation)
+                {
+                    case UnaryOperator::negation: // -(-x) == x, even for INT_MIN
+                    case UnaryOperator::bitwise_complement: // ~~x == x
+                        return inner->innerExpression;
+                    case UnaryOperator::logical_negation:
+                        // !!x == x only if x is already 0 or 1
+                        if (IsBoolean(inner->innerExpression))
+                            return inner->innerExpression;
+                        break;
+                }
+            }
+            return this;
+        }
+        Node** Child(std::size_t i) override { return i == 0 ? &innerExpression : nullptr; }
+    private:
+        static bool IsBoolean(const Node* node)
+        {
+            auto op = dynamic_cast<const UnaryOperation*>(node);
+            return op != nullptr && op->operation == UnaryOperator::logical_negation;
+        }
+        const UnaryOperator operation;
+        Node* innerExpression;
+    };
+
+    class BinaryOp : public Node
+    {
+    public:
+        BinaryOp(BinaryOperator op, Node* _leftExp, Node* _rightExp) :
+            operation(op), leftExp(_leftExp), rightExp(_rightExp) {}
+        BinaryOperator Operation() const { return operation; }
+        const Node& Left() const { return *leftExp; }
+        const Node& Right() const { return *rightExp; }
+        void Accept(Visitor& visitor) const override { visitor.Visit(*this); }
+        const Node* Emit(std::ostream& out, int stage) const override
+        {
+            auto left = dynamic_cast<const IntLiteral*>(leftExp);
+            auto right = dynamic_cast<const IntLiteral*>(rightExp);
+            if (operation == BinaryOperator::multiplication && (right != nullptr || left != nullptr)) // by a constant
+            {
+                if (stage == 0)
+                    return right != nullptr ? leftExp : rightExp;
+                StrengthReduction::Multiply(out, "%eax", (right != nullptr ? right : left)->Value());
+                return nullptr;
+            }
+            if (operation == BinaryOperator::division && right != nullptr && right->Value() != 0) // by a constant
+            {
+                if (stage == 0)
+                    return leftExp;
+                if (!StrengthReduction::DivideByPowerOfTwo(out, "%eax", "%edx", right->Value()))
+                {
+                    out << "movl %eax, %ecx\n";
+                    StrengthReduction::DivideByMagic(out, "%ecx", right->Value());
+                }
+                return nullptr;
+            }
+            // the first operand evaluated waits on the stack, and gets to ecx:
+            // the right one for the division and the subtraction, that want lhs in eax
+            const bool rightFirst = operation == BinaryOperator::division || operation == BinaryOperator::subtraction;
+            switch (stage)
+            {
+                case 0:
+                    return rightFirst ? rightExp : leftExp;
+                case 1:
+                    out << "push %eax\n";
+                    return rightFirst ? leftExp : rightExp;
+            }
+            out << "pop %ecx\n";
+            switch (operation)
+            {
+                case BinaryOperator::multiplication:
+                    out << "imul %ecx, %eax\n";
+                    break;
+                case BinaryOperator::division:
+                    out << "cltd\n"; // sign extend EAX -> EDX:EAX
+                    out << "idivl %ecx\n"; // EDX:EAX / ECX -> EAX
+                    break;
+                case BinaryOperator::addition:
+                    out << "addl %ecx, %eax\n";
+                    break;
+                case BinaryOperator::subtraction:
+                    out << "subl %ecx, %eax\n"; // subl src, dst -> dst=dst-src   eax=eax-ecx
+                    break;
+            }
+            return nullptr;
+        }
+        Node* FoldNode(Arena& arena) override
+        {
+            auto left = dynamic_cast<const IntLiteral*>(leftExp);
+            auto right = dynamic_cast<const IntLiteral*>(rightExp);
+            std::int32_t value;
+            if (left != nullptr && right != nullptr && Compute(operation, left->Value(), right->Value(), value))
+                return arena.Make<IntLiteral>(value);
+            switch (operation)
+            {
+                case BinaryOperator::addition: // x+0 == 0+x == x
+                    if (Is(right, 0)) return leftExp;
+                    if (Is(left, 0)) return rightExp;
+                    break;
+                case BinaryOperator::subtraction: // x-0 == x
+                    if (Is(right, 0)) return leftExp;
+                    break;
+                case BinaryOperator::multiplication: // x*1 == 1*x == x
+                    if (Is(right, 1)) return leftExp;
+                    if (Is(left, 1)) return rightExp;
+                    break;
+                case BinaryOperator::division: // x/1 == x
+                    if (Is(right, 1)) return leftExp;
+                    break;
+            }
+            return this;
+        }
+        Node** Child(std::size_t i) override { return i == 0 ? &leftExp : i == 1 ? &rightExp : nullptr; }
+    private:
+        static bool Is(const IntLiteral* literal, std::int32_t value)
+        {
+            return literal != nullptr && literal->Value() == value;
+        }
+        const BinaryOperator operation;
+        Node* leftExp;
+        Node* rightExp;
+    };
+
+    class Function : public Node
+    {
+    public:
+        // funcName must be stored in the arena, as well
+        Function(std::string_view _funcName, Node* _body) : funcName(_funcName), body(_body) {}
+        std::string_view Name() const { return funcName; }
+        const Node& Body() const { return *body; }
+        void Accept(Visitor& visitor) const override { visitor.Visit(*this); }
+        const Node* Emit(std::ostream& out, int stage) const override
+        {
+            if (stage != 0)
+                return nullptr;
+            out << ".globl " << funcName << "\n"
+                << funcName << ":\n";
+            return body;
+        }
+        Node* FoldNode(Arena&) override { return this; }
+        Node** Child(std::size_t i) override { return i == 0 ? &body : nullptr; }
+    private:
+        const std::string_view funcName;
+        Node* body;
+    };
+} // AST
+
+#endif // AST_H_
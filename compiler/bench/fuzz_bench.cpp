@@ -0,0 +1,417 @@
+// Random program generator, checker and throughput benchmark of dcc.
+//
+// Usage: fuzz_bench [programs [seed]]
+// Generates random valid programs (long +/* chains, deeply nested unary
+// operators and parentheses), checks that each one returns the value
+// computed by the generator itself, independently from the compiler,
+// through the interpreter, the constant folding and the IR passes,
+// and through the code of every backend (stack, registers, ir and the
+// object file), before and after the folding: like samples/check.sh, it
+// assembles, links and runs it with gcc -m32, and compares the exit code.
+// It measures the lines per second through lex + parse and emit.
+// At the end it finds the deepest nesting the compiler can handle
+// before overflowing the stack, running itself as a child process
+// (fuzz_bench --depth parentheses|unary|sum|right N) on larger and larger
+// inputs through the whole pipeline of Compile: parse, the interpreter,
+// fold, and every backend before and after the folding.
+// The crashes of the children would be overflows.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <stdexcept>
+#include <vector>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include "../arena.h"
+#include "../ast.h"
+#include "../elf.h"
+#include "../interpreter.h"
+#include "../ir.h"
+#include "../ir_emitter.h"
+#include "../ir_passes.h"
+#include "../lexer.h"
+#include "../parser.h"
+#include "../regalloc.h"
+#include "../x86.h"
+
+namespace
+{
+    // C semantics on 32 bit ints, with wrapping, computed on uint32
+    std::int32_t Wrap(std::uint32_t x) { return static_cast<std::int32_t>(x); }
+    std::int32_t Add(std::int32_t a, std::int32_t b) { return Wrap(static_cast<std::uint32_t>(a) + static_cast<std::uint32_t>(b)); }
+    std::int32_t Sub(std::int32_t a, std::int32_t b) { return Wrap(static_cast<std::uint32_t>(a) - static_cast<std::uint32_t>(b)); }
+    std::int32_t Mul(std::int32_t a, std::int32_t b) { return Wrap(static_cast<std::uint32_t>(a) * static_cast<std::uint32_t>(b)); }
+    std::int32_t Neg(std::int32_t a) { return Wrap(0u - static_cast<std::uint32_t>(a)); }
+    bool CanDivide(std::int32_t a, std::int32_t b) { return b != 0 && !(a == INT32_MIN && b == -1); }
+
+    // Generates an expression and its value at the same time.
+    // The divisions are generated only where they are defined.
+    class Generator
+    {
+    public:
+        explicit Generator(unsigned seed) : gen(seed) {}
+
+        struct Program
+        {
+            std::string source;
+            std::int32_t value;
+            std::size_t lines;
+        };
+
+        Program Generate()
+        {
+            std::vector<std::string> tokens;
+            const std::int32_t value = Expression(tokens, Random(0, 4), Random(1, 400));
+
+            std::string source = "int main()\n{\n    return";
+            std::size_t lines = 4;
+            for (std::size_t i = 0; i < tokens.size(); ++i)
+            {
+                if (i % 12 == 11) // split the expression in lines
+                {
+                    source += "\n       ";
+                    ++lines;
+                }
+                source += ' ';
+                source += tokens[i];
+            }
+            source += ";\n}\n";
+            return { source, value, lines };
+        }
+
+    private:
+        using Tokens = std::vector<std::string>;
+
+        int Random(int min, int max) { return std::uniform_int_distribution<int>(min, max)(gen); }
+
+        // <exp> ::= <term> { ("+" | "-") <term> }
+        std::int32_t Expression(Tokens& tokens, int depth, int length)
+        {
+            std::int32_t value = Term(tokens, depth, Random(1, 3));
+            for (int i = 1; i < length; ++i)
+            {
+                const bool add = Random(0, 1) == 0;
+                tokens.push_back(add ? "+" : "-");
+                const std::int32_t term = Term(tokens, depth, Random(1, 3));
+                value = add ? Add(value, term) : Sub(value, term);
+            }
+            return value;
+        }
+
+        // <term> ::= <factor> { ("*" | "/") <factor> }
+        std::int32_t Term(Tokens& tokens, int depth, int length)
+        {
+            std::int32_t value = Factor(tokens, depth);
+            for (int i = 1; i < length; ++i)
+            {
+                // the operator depends on the value of the factor that follows it
+                Tokens factorTokens;
+                const std::int32_t factor = Factor(factorTokens, depth);
+                const bool divide = Random(0, 3) == 0 && CanDivide(value, factor);
+                tokens.push_back(divide ? "/" : "*");
+                tokens.insert(tokens.end(), factorTokens.begin(), factorTokens.end());
+                value = divide ? value / factor : Mul(value, factor);
+            }
+            return value;
+        }
+
+        // <factor> ::= "(" <exp> ")" | <unary_op> <factor> | <int_literal>
+        std::int32_t Factor(Tokens& tokens, int depth)
+        {
+            const int choice = Random(0, 9);
+            if (choice < 1 && depth > 0)
+            {
+                tokens.push_back("(");
+                const std::int32_t value = Expression(tokens, depth - 1, Random(1, 10));
+                tokens.push_back(")");
+                return value;
+            }
+            if (choice < 3) // a chain of unary operators, sometimes a long one
+            {
+                std::string ops(Random(1, choice == 1 ? 200 : 4), ' ');
+                for (auto& op: ops)
+                {
+                    op = "-~!"[Random(0, 2)];
+                    tokens.push_back(std::string(1, op));
+                }
+                std::int32_t value = Literal(tokens);
+                for (auto op = ops.rbegin(); op != ops.rend(); ++op)
+                    value = *op == '-' ? Neg(value) : *op == '~' ? ~value : (value == 0);
+                return value;
+            }
+            return Literal(tokens);
+        }
+
+        std::int32_t Literal(Tokens& tokens)
+        {
+            std::uint32_t value;
+            switch (Random(0, 3))
+            {
+                case 0: value = Random(0, 9); break;
+                case 1: value = Random(0, 1000); break;
+                case 2: value = static_cast<std::uint32_t>(Random(0, INT32_MAX)); break;
+                default: value = static_cast<std::uint32_t>(gen()); break; // up to 2^32 - 1
+            }
+            tokens.push_back(std::to_string(value));
+            return Wrap(value);
+        }
+
+        std::mt19937 gen;
+    };
+
+    using Clock = std::chrono::steady_clock;
+    double Seconds(Clock::time_point start) { return std::chrono::duration<double>(Clock::now() - start).count(); }
+
+    // The backends of dcc, run as Compile does: each one writes the code
+    // of the tree in out, as assembly or as an object file
+    struct Backend
+    {
+        const char* name;
+        bool object;
+        void (*emit)(const AST::Node& ast, std::ostream& out);
+    };
+
+    const Backend backends[] = {
+        { "stack", false, [](const AST::Node& ast, std::ostream& out) { ast.Emit(out); } },
+        { "registers", false, [](const AST::Node& ast, std::ostream& out) { RegisterEmitter(out).Emit(ast); } },
+        { "ir", false, [](const AST::Node& ast, std::ostream& out)
+            {
+                auto function = IR::Lowering().Lower(ast);
+                IR::Optimize(function);
+                IR::Emitter(out).Emit(function);
+            } },
+        { "object", true, [](const AST::Node& ast, std::ostream& out)
+            {
+                const auto function = X86::CodeGenerator().Generate(ast);
+                ELF::WriteObject(out, function.name, function.code);
+            } }
+    };
+
+    // Builds and runs the code of the backends in a temporary directory.
+    // The executables get a _start of their own, that exits with the value
+    // of main, so they are linked without the C library.
+    class Runner
+    {
+    public:
+        Runner()
+        {
+            char name[] = "/tmp/fuzz_bench.XXXXXX";
+            if (mkdtemp(name) == nullptr)
+                throw std::runtime_error("Can't create the temporary directory");
+            directory = name;
+            std::ofstream(directory + "/start.s") << ".globl _start\n_start:\ncall main\n"
+                                                     "movl %eax, %ebx\nmovl $1, %eax\nint $0x80\n";
+        }
+        ~Runner() { std::system(("rm -rf \"" + directory + "\"").c_str()); }
+
+        // the exit code of the executable, or -1 if it can't be built or it crashes
+        int Run(const Backend& backend, const AST::Node& ast)
+        {
+            const std::string code = directory + (backend.object ? "/program.o" : "/program.s");
+            const std::string program = directory + "/program";
+            {
+                std::ofstream out(code, std::ios::binary);
+                backend.emit(ast, out);
+            }
+            const std::string link = "gcc -m32 -nostdlib -static \"" + directory + "/start.s\" \"" +
+                                     code + "\" -o \"" + program + "\" 2> /dev/null";
+            if (std::system(link.c_str()) != 0)
+                return -1;
+            const int status = std::system(("exec \"" + program + "\"").c_str());
+            return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+        }
+
+    private:
+        std::string directory;
+    };
+
+    // the first backend whose program doesn't exit with the low byte of expected
+    std::string Run(const AST::Node& ast, std::int32_t expected, Runner& runner, const std::string& tree)
+    {
+        for (const auto& backend: backends)
+        {
+            const int status = runner.Run(backend, ast);
+            if (status != (expected & 255))
+                return "the code of the " + std::string(backend.name) + " backend on the " + tree +
+                       " tree exited with " + std::to_string(status) + " instead of " + std::to_string(expected & 255);
+        }
+        return std::string();
+    }
+
+    // Returns an error message, or an empty string if the program is right
+    std::string Check(AST::Node& ast, std::int32_t expected, Arena& arena, Runner& runner)
+    {
+        const std::int32_t interpreted = Interpreter().Run(ast);
+        if (interpreted != expected)
+            return "interpreter returned " + std::to_string(interpreted);
+
+        auto function = IR::Lowering().Lower(ast);
+        IR::Optimize(function);
+        const auto& ret = function.code.back();
+        if (function.code.size() != 1 || !ret.a.IsConst() || ret.a.value != expected)
+            return "the IR passes didn't reduce it to the constant";
+
+        const std::string error = Run(ast, expected, runner, "parsed");
+        if (!error.empty())
+            return error;
+
+        // Fold works in place, so it comes last
+        auto folded = ast.Fold(arena);
+        auto body = dynamic_cast<const AST::Function*>(folded);
+        auto ret2 = body != nullptr ? dynamic_cast<const AST::Return*>(&body->Body()) : nullptr;
+        auto literal = ret2 != nullptr ? dynamic_cast<const AST::IntLiteral*>(&ret2->Expression()) : nullptr;
+        if (literal == nullptr || literal->Value() != expected)
+            return "the folding didn't reduce it to the constant";
+        return Run(*folded, expected, runner, "folded");
+    }
+
+    std::string Repeat(const std::string& s, std::size_t n)
+    {
+        std::string result;
+        result.reserve(s.size() * n);
+        for (std::size_t i = 0; i < n; ++i)
+            result += s;
+        return result;
+    }
+
+    // fuzz_bench --depth kind n: compiles one expression nested n times,
+    // as Compile does with every option: the interpreter, and every backend
+    // on the tree as parsed and as folded
+    int CompileDeep(const std::string& kind, std::size_t n)
+    {
+        std::string source = "int main() { return ";
+        if (kind == "unary")
+            source += std::string(n, '~') + "1";
+        else if (kind == "sum") // left nested
+            source += "1" + Repeat("+1", n);
+        else if (kind == "right") // right nested
+            source += Repeat("1-(", n) + "1" + std::string(n, ')');
+        else
+            source += std::string(n, '(') + "1" + std::string(n, ')');
+        source += "; }";
+        Arena arena;
+        Grammar<BufferedTokenSource> grammar(BufferedTokenSource(source), arena);
+        auto ast = grammar.Parse();
+        Interpreter().Run(*ast);
+        for (const auto& backend: backends)
+        {
+            std::ostringstream out;
+            backend.emit(*ast, out);
+        }
+        ast = ast->Fold(arena);
+        for (const auto& backend: backends)
+        {
+            std::ostringstream out;
+            backend.emit(*ast, out);
+        }
+        return 0;
+    }
+
+    // true if the child process compiled the input without crashing
+    bool Compiles(const std::string& self, const std::string& kind, std::size_t n)
+    {
+        const std::string command = "\"" + self + "\" --depth " + kind + " " + std::to_string(n);
+        return std::system(command.c_str()) == 0;
+    }
+
+    // the deepest nesting handled, up to limit (a power of two)
+    std::size_t MaxDepth(const std::string& self, const std::string& kind, std::size_t limit)
+    {
+        std::size_t good = 0;
+        std::size_t bad = 1024;
+        while (bad <= limit && Compiles(self, kind, bad))
+        {
+            good = bad;
+            bad *= 2;
+        }
+        if (good == limit)
+            return limit;
+        while (bad - good > good / 100 + 1) // within 1%
+        {
+            const std::size_t middle = good + (bad - good) / 2;
+            (Compiles(self, kind, middle) ? good : bad) = middle;
+        }
+        return good;
+    }
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    try
+    {
+        if (argc == 4 && std::string(argv[1]) == "--depth")
+            return CompileDeep(argv[2], std::stoul(argv[3]));
+
+        const int programs = argc > 1 ? std::stoi(argv[1]) : 500;
+        const unsigned seed = argc > 2 ? std::stoul(argv[2]) : 42;
+
+        Generator generator(seed);
+        Runner runner;
+        Arena arena;
+        std::size_t lines = 0;
+        std::size_t bytes = 0;
+        int failures = 0;
+        double parseSeconds = 0;
+        double emitSeconds = 0;
+        for (int i = 0; i < programs; ++i)
+        {
+            const auto program = generator.Generate();
+            lines += program.lines;
+            bytes += program.source.size();
+
+            auto start = Clock::now();
+            Grammar<BufferedTokenSource> grammar(BufferedTokenSource(program.source), arena);
+            auto ast = grammar.Parse();
+            parseSeconds += Seconds(start);
+
+            std::ostringstream out;
+            start = Clock::now();
+            ast->Emit(out);
+            emitSeconds += Seconds(start);
+
+            const std::string error = Check(*ast, program.value, arena, runner);
+            if (!error.empty())
+            {
+                std::cerr << "FAILED program " << i << " (seed " << seed << "): " << error
+                          << ", expected " << program.value << "\n" << program.source << std::endl;
+                ++failures;
+            }
+            arena.Reset();
+        }
+
+        const double seconds = parseSeconds + emitSeconds;
+        std::cout << std::fixed << std::setprecision(2)
+                  << programs << " programs, " << lines << " lines, " << bytes / 1024.0 / 1024.0 << " MB, "
+                  << failures << " failures\n"
+                  << "    lex + parse: " << std::setw(9) << parseSeconds * 1000 << " ms "
+                  << std::setw(12) << lines / parseSeconds << " lines/s\n"
+                  << "    emit:        " << std::setw(9) << emitSeconds * 1000 << " ms "
+                  << std::setw(12) << lines / emitSeconds << " lines/s\n"
+                  << "    total:       " << std::setw(9) << seconds * 1000 << " ms "
+                  << std::setw(12) << lines / seconds << " lines/s" << std::endl;
+
+        const std::size_t limit = 1 << 22;
+        for (const char* kind: { "parentheses", "unary", "sum", "right" })
+        {
+            const std::size_t depth = MaxDepth(argv[0], kind, limit);
+            std::cout << "max compiler depth (" << kind << "): ";
+            if (depth == limit)
+                std::cout << "no overflow up to " << limit << std::endl;
+            else
+                std::cout << "about " << depth << std::endl;
+        }
+        return failures == 0 ? 0 : 1;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Exception:\n" << e.what() << std::endl;
+    }
+    return 1;
+}
@@ -0,0 +1,149 @@
+// Throughput comparison between the stream lexer (TokenSource)
+// and the buffered lexer (BufferedTokenSource).
+//
+// Usage: lexer_bench [file.c ...]
+// Without arguments, it generates sources of increasing size
+// in the current directory and scans each of them with both lexers.
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include "../lexer.h"
+
+namespace
+{
+    // Write a syntactically valid source of about size bytes:
+    // a single function returning a long expression, split in lines.
+    void Generate(const std::string& fileName, std::size_t size)
+    {
+        std::mt19937 gen(42);
+        std::uniform_int_distribution<int> number(0, 100000);
+        std::uniform_int_distribution<int> choice(0, 5);
+        const char ops[] = { '+', '-', '*', '/' };
+
+        std::ofstream out(fileName, std::ios::binary);
+        out << "int main()\n{\n    return 1";
+        std::size_t written = 0;
+        while (written < size)
+        {
+            std::string line = "\n        ";
+            for (int i = 0; i < 8; ++i)
+            {
+                line += ops[choice(gen) % 4];
+                line += ' ';
+                switch (choice(gen))
+                {
+                    case 0: line += "-"; break;
+                    case 1: line += "~"; break;
+                    case 2: line += "!"; break;
+                    default: break;
+                }
+                line += "(" + std::to_string(number(gen)) + ") ";
+            }
+            out << line;
+            written += line.size();
+        }
+        out << ";\n}\n";
+    }
+
+    template <typename Source>
+    std::size_t CountTokens(Source& source)
+    {
+        std::size_t count = 0;
+        while (source.Next().type != Token::done)
+            ++count;
+        return count;
+    }
+
+    struct Result
+    {
+        double seconds;
+        std::size_t tokens;
+    };
+
+    // the timings include reading the file
+    Result StreamLexer(const std::string& fileName)
+    {
+        const auto t0 = std::chrono::steady_clock::now();
+        std::ifstream input(fileName);
+        TokenSource source(input);
+        const auto tokens = CountTokens(source);
+        const auto t1 = std::chrono::steady_clock::now();
+        return { std::chrono::duration<double>(t1 - t0).count(), tokens };
+    }
+
+    Result BufferedLexer(const std::string& fileName)
+    {
+        const auto t0 = std::chrono::steady_clock::now();
+        const std::string buffer = ReadFile(fileName);
+        BufferedTokenSource source(buffer);
+        const auto tokens = CountTokens(source);
+        const auto t1 = std::chrono::steady_clock::now();
+        return { std::chrono::duration<double>(t1 - t0).count(), tokens };
+    }
+
+    // best of some runs, to filter out the noise
+    template <typename Lexer>
+    Result Best(Lexer lexer, const std::string& fileName)
+    {
+        const int runs = 5;
+        Result best = lexer(fileName);
+        for (int i = 1; i < runs; ++i)
+        {
+            const Result r = lexer(fileName);
+            if (r.seconds < best.seconds)
+                best = r;
+        }
+        return best;
+    }
+
+    void Bench(const std::string& fileName)
+    {
+        std::ifstream in(fileName, std::ios::binary | std::ios::ate);
+        const double mb = static_cast<double>(in.tellg()) / (1024 * 1024);
+
+        const Result stream = Best(StreamLexer, fileName);
+        const Result buffered = Best(BufferedLexer, fileName);
+        if (stream.tokens != buffered.tokens)
+            std::cerr << "Warning: token count mismatch on " << fileName << std::endl;
+
+        std::cout << std::fixed << std::setprecision(2)
+                  << fileName << ": " << mb << " MB, " << buffered.tokens << " tokens\n"
+                  << "    stream:   " << std::setw(8) << stream.seconds * 1000 << " ms "
+                  << std::setw(8) << mb / stream.seconds << " MB/s\n"
+                  << "    buffered: " << std::setw(8) << buffered.seconds * 1000 << " ms "
+                  << std::setw(8) << mb / buffered.seconds << " MB/s\n"
+                  << "    speedup:  " << stream.seconds / buffered.seconds << "x" << std::endl;
+    }
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    try
+    {
+        if (argc > 1)
+        {
+            for (int i = 1; i < argc; ++i)
+                Bench(argv[i]);
+            return 0;
+        }
+
+        for (std::size_t mb : { 1, 4, 16 })
+        {
+            const std::string fileName = "lexer_bench_" + std::to_string(mb) + "mb.c";
+            Generate(fileName, mb * 1024 * 1024);
+            Bench(fileName);
+            std::remove(fileName.c_str());
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Exception:\n" << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,48 @@
+#!/bin/bash
+
+# End-to-end time to get the object files of a set of generated sources:
+# dcc writing the .s and gcc assembling it, against dcc --object.
+# Usage: object_bench.sh [files] [terms]
+# The sources have each one expression with the number of terms passed,
+# and are compiled with --no-fold, to have code to assemble.
+
+export LD_LIBRARY_PATH=/home/daniele/libs/boost_1_66_0/install/x86/lib
+DCC=${DCC:-$(dirname $0)/../dcc}
+FILES=${1:-200}
+TERMS=${2:-2000}
+WORKDIR=$(mktemp -d)
+trap "rm -rf $WORKDIR" EXIT
+
+for ((i = 0; i < FILES; ++i))
+do
+    {
+        printf 'int main()\n{\n    return 1'
+        for ((t = 1; t < TERMS; ++t))
+        do
+            printf ' %s (%d * -%d)' $( ((t % 2)) && echo + || echo - ) $(( (i + t) % 97 )) $(( t % 13 + 1 ))
+        done
+        printf ';\n}\n'
+    } > $WORKDIR/sample$i.c
+done
+
+now() { date +%s%N; }
+
+start=$(now)
+for ((i = 0; i < FILES; ++i))
+do
+    $DCC --no-fold $WORKDIR/sample$i.c > /dev/null || exit 1
+    gcc -m32 -c $WORKDIR/sample$i.s -o $WORKDIR/sample$i.o || exit 1
+done
+text=$(( ($(now) - start) / 1000000 ))
+
+start=$(now)
+for ((i = 0; i < FILES; ++i))
+do
+    $DCC --no-fold --object $WORKDIR/sample$i.c > /dev/null || exit 1
+done
+object=$(( ($(now) - start) / 1000000 ))
+
+echo "$FILES files, $TERMS terms each"
+echo ".s + gcc -c: $text ms"
+echo "--object:    $object ms"
+[ $object -gt 0 ] && echo "speedup:     $(( text * 10 / object / 10 )).$(( text * 10 / object % 10 ))x"
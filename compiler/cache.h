@@ -0,0 +1,238 @@
+// On-disk cache of the compiled files (--cache=DIR).
+// The entries are the .s (or .o) files generated, named after a hash of the
+// source and of the options that change the output: a hit copies the entry
+// next to the source, without parsing it.
+// The least recently used entries are removed when the cache grows over
+// its capacity.
+
+#ifndef CACHE_H_
+#define CACHE_H_
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <boost/filesystem.hpp>
+#include "lexer.h"
+
+class CompilationCache
+{
+public:
+    // throws CompilerError if the directory can't be created
+    CompilationCache(const std::string& _directory, std::uintmax_t _capacity) :
+        directory(_directory), capacity(_capacity)
+    {
+        boost::system::error_code error;
+        boost::filesystem::create_directories(directory, error);
+        if (!boost::filesystem::is_directory(directory))
+            throw CompilerError("Can't create the cache directory " + _directory);
+    }
+
+    // SHA-256 of the source and the options, in hexadecimal.
+    // A collision would serve the output of another file, so the hash must
+    // be a cryptographic one.
+    static std::string Key(std::string_view source, std::string_view options)
+    {
+        Sha256 sha;
+        const auto addLength = [&](std::uint64_t n) // separates source and options
+        {
+            unsigned char bytes[8];
+            for (int i = 0; i < 8; ++i)
+                bytes[i] = static_cast<unsigned char>(n >> (56 - 8 * i));
+            sha.Add(bytes, 8);
+        };
+        addLength(source.size());
+        sha.Add(source.data(), source.size());
+        addLength(options.size());
+        sha.Add(options.data(), options.size());
+        static const char hex[] = "0123456789abcdef";
+        std::string key;
+        for (auto byte: sha.Digest())
+        {
+            key += hex[byte >> 4];
+            key += hex[byte & 0xF];
+        }
+        return key;
+    }
+
+    // If there is an entry for the key, copies it to output and returns true
+    bool Fetch(const std::string& key, const std::string& output)
+    {
+        const auto entry = Entry(key, output);
+        boost::system::error_code error;
+        boost::filesystem::copy_file(entry, output, boost::filesystem::copy_option::overwrite_if_exists, error);
+        if (error)
+        {
+            ++misses;
+            return false;
+        }
+        boost::filesystem::last_write_time(entry, std::time(nullptr), error); // recently used
+        ++hits;
+        return true;
+    }
+
+    // Adds the output to the cache.
+    // The entry is renamed from a temporary file, so that the other
+    // compilations never see it half written.
+    void Store(const std::string& key, const std::string& output)
+    {
+        const auto temp = directory / boost::filesystem::unique_path("%%%%%%%%%%%%.tmp");
+        boost::system::error_code error;
+        boost::filesystem::copy_file(output, temp, error);
+        if (!error)
+            boost::filesystem::rename(temp, Entry(key, output), error);
+        if (error)
+            boost::filesystem::remove(temp, error);
+        else
+            ++stores;
+    }
+
+    // Removes the least recently used entries until the cache fits its capacity
+    void Trim()
+    {
+        struct Item
+        {
+            std::time_t time;
+            std::uintmax_t size;
+            boost::filesystem::path path;
+        };
+        std::vector<Item> items;
+        std::uintmax_t total = 0;
+        boost::system::error_code error;
+        for (boost::filesystem::directory_iterator it(directory, error), end; !error && it != end; it.increment(error))
+        {
+            const auto extension = it->path().extension();
+            if (extension != ".s" && extension != ".o")
+                continue;
+            Item item{ boost::filesystem::last_write_time(it->path(), error), boost::filesystem::file_size(it->path(), error), it->path() };
+            if (error)
+                continue;
+            total += item.size;
+            items.push_back(item);
+        }
+        std::sort(items.begin(), items.end(), [](const Item& a, const Item& b) { return a.time < b.time; });
+        std::size_t removed = 0;
+        for (const auto& item: items)
+        {
+            if (total <= capacity)
+                break;
+            if (boost::filesystem::remove(item.path, error))
+            {
+                total -= item.size;
+                ++removed;
+            }
+        }
+        evictions += removed;
+        size = total;
+        entries = items.size() - removed;
+    }
+
+    // call after Trim
+    void PrintStatistics(std::ostream& out) const
+    {
+        out << "Cache " << directory.string() << ": "
+            << hits << " hits, " << misses << " misses, " << stores << " stored, "
+            << evictions << " evicted, " << entries << " entries, "
+            << size / 1024 << " KB of " << capacity / 1024 << " KB\n";
+    }
+
+private:
+    // SHA-256 (FIPS 180-4)
+    class Sha256
+    {
+    public:
+        void Add(const void* data, std::size_t size)
+        {
+            const auto* bytes = static_cast<const unsigned char*>(data);
+            length += size;
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                block[used++] = bytes[i];
+                if (used == 64)
+                {
+                    Compress();
+                    used = 0;
+                }
+            }
+        }
+        // call once, after all the data
+        std::array<unsigned char, 32> Digest()
+        {
+            const std::uint64_t bits = length * 8;
+            const unsigned char one = 0x80;
+            Add(&one, 1);
+            const unsigned char zero = 0;
+            while (used != 56)
+                Add(&zero, 1);
+            for (int i = 0; i < 8; ++i)
+                block[56 + i] = static_cast<unsigned char>(bits >> (56 - 8 * i));
+            Compress();
+            std::array<unsigned char, 32> digest;
+            for (int i = 0; i < 32; ++i)
+                digest[i] = static_cast<unsigned char>(state[i / 4] >> (24 - 8 * (i % 4)));
+            return digest;
+        }
+    private:
+        static std::uint32_t Rotate(std::uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+        void Compress()
+        {
+            static const std::uint32_t k[64] = {
+                0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+                0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+                0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+                0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+                0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+                0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+                0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+                0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+            };
+            std::uint32_t w[64];
+            for (int i = 0; i < 16; ++i)
+                w[i] = (std::uint32_t(block[4 * i]) << 24) | (std::uint32_t(block[4 * i + 1]) << 16) |
+                       (std::uint32_t(block[4 * i + 2]) << 8) | std::uint32_t(block[4 * i + 3]);
+            for (int i = 16; i < 64; ++i)
+            {
+                const std::uint32_t s0 = Rotate(w[i - 15], 7) ^ Rotate(w[i - 15], 18) ^ (w[i - 15] >> 3);
+                const std::uint32_t s1 = Rotate(w[i - 2], 17) ^ Rotate(w[i - 2], 19) ^ (w[i - 2] >> 10);
+                w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+            }
+            std::uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+            std::uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+            for (int i = 0; i < 64; ++i)
+            {
+                const std::uint32_t t1 = h + (Rotate(e, 6) ^ Rotate(e, 11) ^ Rotate(e, 25)) + ((e & f) ^ (~e & g)) + k[i] + w[i];
+                const std::uint32_t t2 = (Rotate(a, 2) ^ Rotate(a, 13) ^ Rotate(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+                h = g; g = f; f = e; e = d + t1;
+                d = c; c = b; b = a; a = t1 + t2;
+            }
+            state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+            state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+        }
+
+        std::uint32_t state[8] = { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+        unsigned char block[64];
+        std::size_t used = 0; // bytes in block
+        std::uint64_t length = 0; // bytes added
+    };
+
+    boost::filesystem::path Entry(const std::string& key, const std::string& output) const
+    {
+        return directory / (key + boost::filesystem::extension(output));
+    }
+
+    const boost::filesystem::path directory;
+    const std::uintmax_t capacity;
+    std::atomic<std::size_t> hits{ 0 };
+    std::atomic<std::size_t> misses{ 0 };
+    std::atomic<std::size_t> stores{ 0 };
+    std::size_t evictions = 0;
+    std::size_t entries = 0;
+    std::uintmax_t size = 0;
+};
+
+#endif // CACHE_H_
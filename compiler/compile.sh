@@ -5,5 +5,7 @@ EXE=dcc
 # CXX=g++
 CXX=clang++-5.0
 
-${CXX} -std=c++1y -Wall -O3 main.cpp -o $EXE -isystem /home/daniele/libs/boost_1_66_0/install/x86/include -L /home/daniele/libs/boost_1_66_0/install/x86/lib -lboost_filesystem -lboost_system
-# ${CXX} -std=c++1y -Wall -O3 spirit_grammar.cpp -o $EXE -isystem /home/daniele/libs/boost_1_66_0/install/x86/include -L /home/daniele/libs/boost_1_66_0/install/x86/lib -lboost_filesystem -lboost_system
+${CXX} -std=c++17 -Wall -O3 -pthread main.cpp -o $EXE -isystem /home/daniele/libs/boost_1_66_0/install/x86/include -L /home/daniele/libs/boost_1_66_0/install/x86/lib -lboost_filesystem -lboost_system -lboost_chrono
+${CXX} -std=c++17 -Wall -O3 bench/lexer_bench.cpp -o lexer_bench
+${CXX} -std=c++17 -Wall -O3 bench/fuzz_bench.cpp -o fuzz_bench
+# ${CXX} -std=c++1y -Wall -O3 spirit_grammar.cpp -o $EXE -isystem /home/daniele/libs/boost_1_66_0/install/x86/include -L /home/daniele/libs/boost_1_66_0/install/x86/lib -lboost_filesystem -lboost_system -lboost_chrono
@@ -0,0 +1,188 @@
+// Writer of ELF32 relocatable object files (i386), the same that
+// "as --32" produces from the .s file: a .text section with one
+// global function. The code has no external references, so there are no
+// relocations.
+// See the System V ABI, "Object Files", and /usr/include/elf.h.
+
+#ifndef ELF_H_
+#define ELF_H_
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ELF
+{
+    namespace detail
+    {
+        // little endian output, whatever the host
+        class Buffer
+        {
+        public:
+            std::size_t Size() const { return data.size(); }
+            const std::vector<char>& Data() const { return data; }
+
+            void Byte(std::uint8_t b) { data.push_back(static_cast<char>(b)); }
+            void Half(std::uint16_t h) { Byte(h & 0xFF); Byte(h >> 8); }
+            void Word(std::uint32_t w) { Half(w & 0xFFFF); Half(w >> 16); }
+            void Bytes(const void* p, std::size_t size)
+            {
+                auto bytes = static_cast<const char*>(p);
+                data.insert(data.end(), bytes, bytes + size);
+            }
+            void Align(std::size_t alignment)
+            {
+                while (data.size() % alignment != 0)
+                    Byte(0);
+            }
+        private:
+            std::vector<char> data;
+        };
+
+        // a string table: offsets of the names added
+        class StringTable
+        {
+        public:
+            StringTable() : data(1, '\0') {}
+            std::uint32_t Add(std::string_view name)
+            {
+                const auto offset = static_cast<std::uint32_t>(data.size());
+                data.append(name);
+                data.push_back('\0');
+                return offset;
+            }
+            const std::string& Data() const { return data; }
+        private:
+            std::string data;
+        };
+
+        struct Section
+        {
+            std::uint32_t name = 0;
+            std::uint32_t type = 0;
+            std::uint32_t flags = 0;
+            std::uint32_t offset = 0;
+            std::uint32_t size = 0;
+            std::uint32_t link = 0;
+            std::uint32_t info = 0;
+            std::uint32_t alignment = 0;
+            std::uint32_t entrySize = 0;
+        };
+
+        enum : std::uint32_t
+        {
+            SHT_PROGBITS = 1, SHT_SYMTAB = 2, SHT_STRTAB = 3,
+            SHF_ALLOC = 2, SHF_EXECINSTR = 4,
+            STB_GLOBAL = 1, STT_FUNC = 2,
+            ET_REL = 1, EM_386 = 3, EV_CURRENT = 1
+        };
+    } // detail
+
+    // Writes the object file with the code of the function,
+    // out must be opened in binary mode.
+    inline void WriteObject(std::ostream& out, std::string_view function, const std::vector<std::uint8_t>& code)
+    {
+        using namespace detail;
+        enum { null_section, text, symtab, strtab, shstrtab, note_gnu_stack, section_count };
+        const std::uint32_t headerSize = 52;
+        const std::uint32_t sectionHeaderSize = 40;
+        const std::uint32_t symbolSize = 16;
+
+        StringTable sectionNames;
+        StringTable symbolNames;
+        Section sections[section_count];
+        sections[text].name = sectionNames.Add(".text");
+        sections[symtab].name = sectionNames.Add(".symtab");
+        sections[strtab].name = sectionNames.Add(".strtab");
+        sections[shstrtab].name = sectionNames.Add(".shstrtab");
+        // no executable stack
+        sections[note_gnu_stack].name = sectionNames.Add(".note.GNU-stack");
+
+        Buffer body; // what follows the ELF header
+        auto align = [&](std::uint32_t alignment) // the offset in the file
+        {
+            while ((headerSize + body.Size()) % alignment != 0)
+                body.Byte(0);
+        };
+        auto place = [&](Section& section, std::uint32_t type, std::uint32_t alignment)
+        {
+            align(alignment);
+            section.type = type;
+            section.alignment = alignment;
+            section.offset = static_cast<std::uint32_t>(headerSize + body.Size());
+        };
+
+        place(sections[text], SHT_PROGBITS, 16);
+        sections[text].flags = SHF_ALLOC | SHF_EXECINSTR;
+        sections[text].size = static_cast<std::uint32_t>(code.size());
+        body.Bytes(code.data(), code.size());
+
+        // the null symbol and the function
+        place(sections[symtab], SHT_SYMTAB, 4);
+        for (int i = 0; i < 4; ++i)
+            body.Word(0);
+        body.Word(symbolNames.Add(function));
+        body.Word(0); // value: the offset in .text
+        body.Word(static_cast<std::uint32_t>(code.size()));
+        body.Byte(STB_GLOBAL << 4 | STT_FUNC);
+        body.Byte(0); // default visibility
+        body.Half(text);
+        sections[symtab].size = 2 * symbolSize;
+        sections[symtab].entrySize = symbolSize;
+        sections[symtab].link = strtab;
+        sections[symtab].info = 1; // the index of the first global symbol
+
+        place(sections[strtab], SHT_STRTAB, 1);
+        sections[strtab].size = static_cast<std::uint32_t>(symbolNames.Data().size());
+        body.Bytes(symbolNames.Data().data(), symbolNames.Data().size());
+
+        place(sections[shstrtab], SHT_STRTAB, 1);
+        sections[shstrtab].size = static_cast<std::uint32_t>(sectionNames.Data().size());
+        body.Bytes(sectionNames.Data().data(), sectionNames.Data().size());
+
+        place(sections[note_gnu_stack], SHT_PROGBITS, 1);
+
+        align(4);
+        const auto sectionHeaders = static_cast<std::uint32_t>(headerSize + body.Size());
+        for (const auto& s: sections)
+        {
+            body.Word(s.name);
+            body.Word(s.type);
+            body.Word(s.flags);
+            body.Word(0); // address
+            body.Word(s.offset);
+            body.Word(s.size);
+            body.Word(s.link);
+            body.Word(s.info);
+            body.Word(s.alignment);
+            body.Word(s.entrySize);
+        }
+
+        Buffer header;
+        header.Bytes("\x7f" "ELF", 4);
+        header.Byte(1); // 32 bit
+        header.Byte(1); // little endian
+        header.Byte(EV_CURRENT);
+        header.Align(16); // System V ABI and padding
+        header.Half(ET_REL);
+        header.Half(EM_386);
+        header.Word(EV_CURRENT);
+        header.Word(0); // entry point
+        header.Word(0); // program headers
+        header.Word(sectionHeaders);
+        header.Word(0); // flags
+        header.Half(headerSize);
+        header.Half(0); // program header size
+        header.Half(0); // program header count
+        header.Half(sectionHeaderSize);
+        header.Half(section_count);
+        header.Half(shstrtab);
+
+        out.write(header.Data().data(), header.Size());
+        out.write(body.Data().data(), body.Size());
+    }
+} // ELF
+
+#endif // ELF_H_
@@ -0,0 +1,61 @@
+// Tree walking interpreter of dcc: computes the value returned by the program
+// without generating code. It's the reference to check the backends against.
+
+#ifndef INTERPRETER_H_
+#define INTERPRETER_H_
+
+#include <cstdint>
+#include <vector>
+#include "ast.h"
+#include "lexer.h"
+
+class Interpreter : private AST::StepVisitor
+{
+public:
+    // throws CompilerError if the program has undefined behavior
+    std::int32_t Run(const AST::Node& root)
+    {
+        values.clear();
+        Walk(root);
+        return values.back();
+    }
+
+private:
+    // the values of the children are on top of values when the last step
+    // of a node is visited: it replaces them with its own
+    void Visit(const AST::IntLiteral& node) override { values.push_back(node.Value()); }
+    void Visit(const AST::Return& node) override
+    {
+        if (Stage() == 0)
+            Then(node.Expression());
+    }
+    void Visit(const AST::Function& node) override
+    {
+        if (Stage() == 0)
+            Then(node.Body());
+    }
+    void Visit(const AST::UnaryOperation& node) override
+    {
+        if (Stage() == 0)
+            Then(node.Operand());
+        else
+            values.back() = AST::Compute(node.Operation(), values.back());
+    }
+    void Visit(const AST::BinaryOp& node) override
+    {
+        switch (Stage())
+        {
+            case 0: Then(node.Left()); return;
+            case 1: Then(node.Right()); return;
+        }
+        const std::int32_t r = values.back();
+        values.pop_back();
+        const std::int32_t l = values.back();
+        if (!AST::Compute(node.Operation(), l, r, values.back()))
+            throw CompilerError(r == 0 ? "Division by zero" : "Integer overflow in division");
+    }
+
+    std::vector<std::int32_t> values;
+};
+
+#endif // INTERPRETER_H_
@@ -0,0 +1,198 @@
+// Intermediate representation of dcc: a function is a flat vector of
+// three-address instructions over an unlimited number of virtual registers.
+// The lowering from the AST assigns each virtual register exactly once (SSA),
+// and the passes keep this property.
+
+#ifndef IR_H_
+#define IR_H_
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "ast.h"
+
+namespace IR
+{
+    using VReg = std::int32_t;
+
+    enum class Opcode
+    {
+        move,        // dest = a
+        neg,         // dest = -a
+        not_,        // dest = ~a
+        lnot,        // dest = !a
+        add,         // dest = a + b
+        sub,         // dest = a - b
+        mul,         // dest = a * b
+        div,         // dest = a / b
+        ret          // return a
+    };
+
+    // a virtual register or a constant
+    struct Operand
+    {
+        enum Kind : std::uint8_t { none, vreg, constant };
+        Kind kind = none;
+        std::int32_t value = 0; // the number of the register or the constant
+
+        static Operand Reg(VReg r) { return { vreg, r }; }
+        static Operand Const(std::int32_t c) { return { constant, c }; }
+        bool IsReg() const { return kind == vreg; }
+        bool IsConst() const { return kind == constant; }
+    };
+
+    struct Instruction
+    {
+        Opcode op;
+        VReg dest; // not used by ret
+        Operand a;
+        Operand b; // only for the binary operations
+
+        bool IsBinary() const { return op >= Opcode::add && op <= Opcode::div; }
+    };
+
+    struct Function
+    {
+        std::string name;
+        std::vector<Instruction> code;
+        VReg registers = 0; // number of virtual registers used
+    };
+
+    inline const char* Name(Opcode op)
+    {
+        switch (op)
+        {
+            case Opcode::move: return "move";
+            case Opcode::neg: return "neg";
+            case Opcode::not_: return "not";
+            case Opcode::lnot: return "lnot";
+            case Opcode::add: return "add";
+            case Opcode::sub: return "sub";
+            case Opcode::mul: return "mul";
+            case Opcode::div: return "div";
+            case Opcode::ret: return "ret";
+        }
+        return "???"; // can't reach this point
+    }
+
+    inline std::ostream& operator << (std::ostream& out, const Operand& operand)
+    {
+        if (operand.IsReg())
+            return out << 'v' << operand.value;
+        return out << operand.value;
+    }
+
+    inline void Print(std::ostream& out, const Function& function)
+    {
+        out << function.name << ":\n";
+        for (const auto& i: function.code)
+        {
+            out << "    ";
+            if (i.op != Opcode::ret)
+                out << 'v' << i.dest << " = ";
+            out << Name(i.op) << ' ' << i.a;
+            if (i.IsBinary())
+                out << ", " << i.b;
+            out << '\n';
+        }
+    }
+
+    // Translate the tree into IR
+    class Lowering : private AST::StepVisitor
+    {
+    public:
+        Function Lower(const AST::Node& root)
+        {
+            function = Function();
+            results.clear();
+            Walk(root);
+            return std::move(function);
+        }
+
+    private:
+        VReg Add(Opcode op, Operand a, Operand b = Operand())
+        {
+            const VReg dest = function.registers++;
+            function.code.push_back(Instruction{ op, dest, a, b });
+            return dest;
+        }
+
+        // the registers holding the values of the children are on top of
+        // results when the last step of a node is visited: it replaces them
+        // with its own
+        VReg Pop()
+        {
+            const VReg r = results.back();
+            results.pop_back();
+            return r;
+        }
+
+        void Visit(const AST::IntLiteral& node) override
+        {
+            results.push_back(Add(Opcode::move, Operand::Const(node.Value())));
+        }
+
+        void Visit(const AST::UnaryOperation& node) override
+        {
+            if (Stage() == 0)
+            {
+                Then(node.Operand());
+                return;
+            }
+            const VReg operand = Pop();
+            Opcode op = Opcode::neg;
+            switch (node.Operation())
+            {
+                case AST::UnaryOperator::negation: op = Opcode::neg; break;
+                case AST::UnaryOperator::bitwise_complement: op = Opcode::not_; break;
+                case AST::UnaryOperator::logical_negation: op = Opcode::lnot; break;
+            }
+            results.push_back(Add(op, Operand::Reg(operand)));
+        }
+
+        void Visit(const AST::BinaryOp& node) override
+        {
+            switch (Stage())
+            {
+                case 0: Then(node.Left()); return;
+                case 1: Then(node.Right()); return;
+            }
+            const VReg r = Pop();
+            const VReg l = Pop();
+            Opcode op = Opcode::add;
+            switch (node.Operation())
+            {
+                case AST::BinaryOperator::addition: op = Opcode::add; break;
+                case AST::BinaryOperator::subtraction: op = Opcode::sub; break;
+                case AST::BinaryOperator::multiplication: op = Opcode::mul; break;
+                case AST::BinaryOperator::division: op = Opcode::div; break;
+            }
+            results.push_back(Add(op, Operand::Reg(l), Operand::Reg(r)));
+        }
+
+        void Visit(const AST::Return& node) override
+        {
+            if (Stage() == 0)
+            {
+                Then(node.Expression());
+                return;
+            }
+            function.code.push_back(Instruction{ Opcode::ret, 0, Operand::Reg(Pop()), Operand() });
+        }
+
+        void Visit(const AST::Function& node) override
+        {
+            if (Stage() == 0)
+            {
+                function.name = std::string(node.Name());
+                Then(node.Body());
+            }
+        }
+
+        Function function;
+        std::vector<VReg> results;
+    };
+} // IR
+
+#endif // IR_H_
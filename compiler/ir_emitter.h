@@ -0,0 +1,320 @@
+// x86 backend from the IR.
+//
+// The virtual registers are assigned to ecx, ebx, esi and edi with the
+// linear scan algorithm (Poletto, Sarkar "Linear scan register allocation"),
+// the ones that don't fit go in stack slots for their whole life.
+// eax and edx are not allocated: they are the scratch registers needed by
+// the instructions that work only on them (idivl, sete, the return value).
+
+#ifndef IR_EMITTER_H_
+#define IR_EMITTER_H_
+
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "ir.h"
+#include "strength.h"
+
+namespace IR
+{
+    class Emitter
+    {
+    public:
+        explicit Emitter(std::ostream& _out) : out(_out) {}
+
+        void Emit(const Function& function)
+        {
+            Allocate(function);
+
+            std::ostringstream body;
+            for (const auto& i: function.code)
+                Emit(body, i);
+
+            out << ".globl " << function.name << "\n"
+                << function.name << ":\n";
+            for (int r = 0; r < register_count; ++r)
+                if (used[r] && CalleeSaved(static_cast<Register>(r)))
+                    out << "push " << Name(static_cast<Register>(r)) << "\n";
+            if (FrameSize() > 0)
+                out << "subl $" << FrameSize() << ", %esp\n";
+            out << body.str();
+        }
+
+    private:
+        enum Register { ecx, ebx, esi, edi, register_count };
+
+        static const char* Name(Register r)
+        {
+            static const char* const names[] = { "%ecx", "%ebx", "%esi", "%edi" };
+            return names[r];
+        }
+        static bool CalleeSaved(Register r) { return r != ecx; }
+
+        // where a virtual register lives
+        struct Location
+        {
+            bool inRegister = true;
+            int index = 0; // the register or the stack slot
+        };
+
+        /////////////////////////////////////////////////////////////
+        // register allocation
+
+        void Allocate(const Function& function)
+        {
+            // live intervals: the code is SSA, so each one goes
+            // from the definition to the last use
+            end.assign(function.registers, 0);
+            for (std::size_t n = 0; n < function.code.size(); ++n)
+            {
+                const auto& i = function.code[n];
+                if (i.op != Opcode::ret)
+                    end[i.dest] = n;
+                if (i.a.IsReg()) end[i.a.value] = n;
+                if (i.b.IsReg()) end[i.b.value] = n;
+            }
+
+            locations.assign(function.registers, Location());
+            slots = 0;
+            std::vector<VReg> active; // the intervals in a register
+            for (std::size_t n = 0; n < function.code.size(); ++n)
+            {
+                const auto& i = function.code[n];
+                if (i.op == Opcode::ret)
+                    continue;
+
+                // the intervals ended before this instruction release their registers
+                Register hint = register_count;
+                for (auto it = active.begin(); it != active.end(); )
+                {
+                    if (end[*it] < n)
+                        it = active.erase(it);
+                    else
+                    {
+                        // the result can go in the register of the first operand
+                        // if this is its last use: then the instruction needs no move
+                        if (i.a.IsReg() && *it == i.a.value && end[*it] == n)
+                        {
+                            hint = static_cast<Register>(locations[*it].index);
+                            it = active.erase(it);
+                        }
+                        else
+                            ++it;
+                    }
+                }
+
+                const VReg v = i.dest;
+                if (hint != register_count)
+                    Assign(v, hint);
+                else if (active.size() < register_count)
+                    Assign(v, FreeRegister(active));
+                else
+                {
+                    // spill the interval that ends last
+                    auto furthest = active.begin();
+                    for (auto it = active.begin(); it != active.end(); ++it)
+                        if (end[*it] > end[*furthest])
+                            furthest = it;
+                    if (end[*furthest] > end[v])
+                    {
+                        Assign(v, static_cast<Register>(locations[*furthest].index));
+                        Spill(*furthest);
+                        active.erase(furthest);
+                    }
+                    else
+                    {
+                        Spill(v);
+                        continue;
+                    }
+                }
+                active.push_back(v);
+            }
+        }
+
+        Register FreeRegister(const std::vector<VReg>& active) const
+        {
+            for (int r = 0; r < register_count; ++r)
+            {
+                bool free = true;
+                for (VReg v: active)
+                    if (locations[v].index == r)
+                        free = false;
+                if (free)
+                    return static_cast<Register>(r);
+            }
+            return register_count; // can't reach this point
+        }
+
+        void Assign(VReg v, Register r)
+        {
+            locations[v].inRegister = true;
+            locations[v].index = r;
+            used[r] = true;
+        }
+
+        void Spill(VReg v)
+        {
+            locations[v].inRegister = false;
+            locations[v].index = slots++;
+        }
+
+        /////////////////////////////////////////////////////////////
+        // code generation
+
+        // the stack slots for the spilled registers, plus one (if needed)
+        // to hold a constant operand where x86 wants a register or memory
+        int FrameSize() const { return 4 * (slots + (usesTemp ? 1 : 0)); }
+        std::string Temp()
+        {
+            usesTemp = true;
+            return std::to_string(4 * slots) + "(%esp)";
+        }
+
+        std::string Where(VReg v) const
+        {
+            const auto& l = locations[v];
+            if (l.inRegister)
+                return Name(static_cast<Register>(l.index));
+            return std::to_string(4 * l.index) + "(%esp)";
+        }
+
+        std::string Where(const Operand& operand) const
+        {
+            if (operand.IsConst())
+                return "$" + std::to_string(operand.value);
+            return Where(operand.value);
+        }
+
+        static bool IsMemory(const std::string& location) { return location.back() == ')'; }
+
+        static void Move(std::ostream& o, const std::string& from, const std::string& to)
+        {
+            if (from == to)
+                return;
+            if (IsMemory(from) && IsMemory(to))
+            {
+                o << "movl " << from << ", %eax\n";
+                o << "movl %eax, " << to << "\n";
+            }
+            else
+                o << "movl " << from << ", " << to << "\n";
+        }
+
+        static const char* Mnemonic(Opcode op)
+        {
+            switch (op)
+            {
+                case Opcode::neg: return "neg";
+                case Opcode::not_: return "not";
+                case Opcode::add: return "addl";
+                case Opcode::sub: return "subl";
+                case Opcode::mul: return "imull";
+                default: return "???";
+            }
+        }
+
+        void Emit(std::ostream& o, IR::Instruction i)
+        {
+            // put the constant on the right, where it can be an immediate
+            if ((i.op == Opcode::add || i.op == Opcode::mul) && i.a.IsConst() && !i.b.IsConst())
+                std::swap(i.a, i.b);
+
+            const std::string a = Where(i.a);
+            const std::string b = i.IsBinary() ? Where(i.b) : std::string();
+            const std::string dest = i.op == Opcode::ret ? std::string() : Where(i.dest);
+            // the register where the result is computed
+            const std::string work = (i.op == Opcode::ret || IsMemory(dest)) ? "%eax" : dest;
+
+            switch (i.op)
+            {
+                case Opcode::move:
+                    Move(o, a, dest);
+                    break;
+                case Opcode::neg:
+                case Opcode::not_:
+                    Move(o, a, work);
+                    o << Mnemonic(i.op) << " " << work << "\n";
+                    Move(o, work, dest);
+                    break;
+                case Opcode::lnot:
+                    if (i.a.IsConst())
+                    {
+                        Move(o, a, "%eax");
+                        o << "cmpl $0, %eax\n";
+                    }
+                    else
+                        o << "cmpl $0, " << a << "\n";
+                    o << "movl $0, %eax\n";
+                    o << "sete %al\n";
+                    Move(o, "%eax", dest);
+                    break;
+                case Opcode::add:
+                case Opcode::sub:
+                case Opcode::mul:
+                    Move(o, a, work);
+                    if (i.op == Opcode::mul && i.b.IsConst())
+                        StrengthReduction::Multiply(o, work.c_str(), i.b.value);
+                    else
+                        o << Mnemonic(i.op) << " " << b << ", " << work << "\n";
+                    Move(o, work, dest);
+                    break;
+                case Opcode::div:
+                    Divide(o, i, a, b);
+                    Move(o, "%eax", dest);
+                    break;
+                case Opcode::ret:
+                    Move(o, a, "%eax");
+                    if (FrameSize() > 0)
+                        o << "addl $" << FrameSize() << ", %esp\n";
+                    for (int r = register_count - 1; r >= 0; --r)
+                        if (used[r] && CalleeSaved(static_cast<Register>(r)))
+                            o << "pop " << Name(static_cast<Register>(r)) << "\n";
+                    o << "ret\n";
+                    break;
+            }
+        }
+
+        // eax = a / b
+        void Divide(std::ostream& o, const IR::Instruction& i, const std::string& a, const std::string& b)
+        {
+            if (i.b.IsConst() && i.b.value != 0)
+            {
+                const std::int32_t d = i.b.value;
+                if (StrengthReduction::IsPowerOfTwo(d))
+                {
+                    Move(o, a, "%eax");
+                    StrengthReduction::DivideByPowerOfTwo(o, "%eax", "%edx", d);
+                }
+                else if (i.a.IsConst())
+                {
+                    const std::string temp = Temp();
+                    Move(o, a, temp);
+                    StrengthReduction::DivideByMagic(o, temp.c_str(), d);
+                }
+                else
+                    StrengthReduction::DivideByMagic(o, a.c_str(), d);
+                return;
+            }
+            std::string divisor = b;
+            if (i.b.IsConst())
+            {
+                divisor = Temp();
+                Move(o, b, divisor);
+            }
+            Move(o, a, "%eax");
+            o << "cltd\n";
+            o << "idivl " << divisor << "\n";
+        }
+
+        std::ostream& out;
+        std::vector<std::size_t> end;
+        std::vector<Location> locations;
+        int slots = 0;
+        bool usesTemp = false;
+        bool used[register_count] = {};
+    };
+} // IR
+
+#endif // IR_EMITTER_H_
@@ -0,0 +1,121 @@
+// Optimization passes over the IR.
+// Each pass is a linear scan of the instruction vector:
+// the code is in SSA form, so a definition always precedes its uses.
+
+#ifndef IR_PASSES_H_
+#define IR_PASSES_H_
+
+#include <vector>
+#include "ir.h"
+
+namespace IR
+{
+    namespace detail
+    {
+        // Computes the result of an instruction whose operands are constants.
+        // Returns false if it's undefined (it's left to run time).
+        inline bool Compute(const Instruction& i, std::int32_t& result)
+        {
+            const std::int32_t a = i.a.value;
+            const std::int32_t b = i.b.value;
+            switch (i.op)
+            {
+                case Opcode::move: result = a; return true;
+                case Opcode::neg: result = AST::Compute(AST::UnaryOperator::negation, a); return true;
+                case Opcode::not_: result = AST::Compute(AST::UnaryOperator::bitwise_complement, a); return true;
+                case Opcode::lnot: result = AST::Compute(AST::UnaryOperator::logical_negation, a); return true;
+                case Opcode::add: return AST::Compute(AST::BinaryOperator::addition, a, b, result);
+                case Opcode::sub: return AST::Compute(AST::BinaryOperator::subtraction, a, b, result);
+                case Opcode::mul: return AST::Compute(AST::BinaryOperator::multiplication, a, b, result);
+                case Opcode::div: return AST::Compute(AST::BinaryOperator::division, a, b, result);
+                case Opcode::ret: return false;
+            }
+            return false; // can't reach this point
+        }
+
+        // replace the operand, if it's a register, with its value in values
+        inline void Substitute(Operand& operand, const std::vector<Operand>& values)
+        {
+            if (operand.IsReg() && values[operand.value].kind != Operand::none)
+                operand = values[operand.value];
+        }
+    } // detail
+
+    // Replaces the uses of the destination of each move with its source.
+    // The moves become dead code.
+    inline void CopyPropagation(Function& function)
+    {
+        std::vector<Operand> copies(function.registers);
+        for (auto& i: function.code)
+        {
+            detail::Substitute(i.a, copies);
+            detail::Substitute(i.b, copies);
+            if (i.op == Opcode::move)
+                copies[i.dest] = i.a;
+        }
+    }
+
+    // Replaces the uses of the registers holding a constant with the constant,
+    // and the instructions with only constant operands with a move of the result.
+    inline void ConstantPropagation(Function& function)
+    {
+        std::vector<Operand> constants(function.registers);
+        for (auto& i: function.code)
+        {
+            detail::Substitute(i.a, constants);
+            detail::Substitute(i.b, constants);
+            std::int32_t value;
+            if (i.op != Opcode::ret && i.a.IsConst() && (!i.IsBinary() || i.b.IsConst()) &&
+                detail::Compute(i, value))
+            {
+                i = Instruction{ Opcode::move, i.dest, Operand::Const(value), Operand() };
+                constants[i.dest] = i.a;
+            }
+        }
+    }
+
+    // Removes the instructions whose result is never used.
+    // There are no side effects, so only ret is always live.
+    inline void DeadCodeElimination(Function& function)
+    {
+        std::vector<bool> live(function.registers, false);
+        std::vector<bool> dead(function.code.size(), false);
+        for (std::size_t n = function.code.size(); n-- > 0; )
+        {
+            const auto& i = function.code[n];
+            if (i.op != Opcode::ret && !live[i.dest])
+            {
+                dead[n] = true;
+                continue;
+            }
+            if (i.a.IsReg()) live[i.a.value] = true;
+            if (i.b.IsReg()) live[i.b.value] = true;
+        }
+        std::size_t kept = 0;
+        for (std::size_t n = 0; n < function.code.size(); ++n)
+            if (!dead[n])
+                function.code[kept++] = function.code[n];
+        function.code.resize(kept);
+    }
+
+    struct Pass
+    {
+        const char* name;
+        void (*run)(Function&);
+    };
+
+    // the passes run by Optimize, in order
+    inline const Pass passes[] = {
+        { "copy propagation", CopyPropagation },
+        { "constant propagation", ConstantPropagation },
+        { "dead code elimination", DeadCodeElimination }
+    };
+
+    inline void Optimize(Function& function)
+    {
+        for (const auto& pass: passes)
+            pass.run(function);
+    }
+} // IR
+
+#endif // IR_PASSES_H_
@@ -0,0 +1,109 @@
+// Keywords of dcc and their lookup with a perfect hash.
+// The hash function and its table are computed at compile time from the
+// list of keywords: adding a keyword is adding it to Keyword and keywordNames.
+// A lookup is a hash of the first and last character and the length,
+// plus at most one string comparison.
+
+#ifndef KEYWORDS_H_
+#define KEYWORDS_H_
+
+#include <array>
+#include <cstddef>
+#include <string_view>
+
+enum class Keyword : unsigned char
+{
+    none, // not a keyword
+    return_,
+    int_,
+    float_
+};
+
+// the names of the keywords, in the order of Keyword (after none)
+inline constexpr std::string_view keywordNames[] = { "return", "int", "float" };
+
+inline constexpr std::string_view Name(Keyword k)
+{
+    return k == Keyword::none ? std::string_view("<none>") : keywordNames[static_cast<std::size_t>(k) - 1];
+}
+
+namespace detail
+{
+    constexpr std::size_t keyword_count = std::size(keywordNames);
+
+    // power of two at least twice the number of keywords
+    constexpr std::size_t KeywordTableSize()
+    {
+        std::size_t size = 1;
+        while (size < 2 * keyword_count)
+            size *= 2;
+        return size;
+    }
+    constexpr std::size_t keyword_table_size = KeywordTableSize();
+
+    constexpr std::size_t KeywordHash(std::string_view s, std::size_t seed)
+    {
+        const auto first = static_cast<unsigned char>(s.front());
+        const auto last = static_cast<unsigned char>(s.back());
+        return (first * seed + last + s.size() * 7) & (keyword_table_size - 1);
+    }
+
+    // the first seed without collisions among the keywords
+    constexpr std::size_t KeywordSeed()
+    {
+        for (std::size_t seed = 1; seed < 1000; ++seed)
+        {
+            bool used[keyword_table_size] = {};
+            bool collision = false;
+            for (auto name: keywordNames)
+            {
+                auto& slot = used[KeywordHash(name, seed)];
+                collision = collision || slot;
+                slot = true;
+            }
+            if (!collision)
+                return seed;
+        }
+        return 0;
+    }
+    constexpr std::size_t keyword_seed = KeywordSeed();
+    static_assert(keyword_seed != 0, "no perfect hash for the keywords: change KeywordHash");
+
+    constexpr std::array<Keyword, keyword_table_size> KeywordTable()
+    {
+        std::array<Keyword, keyword_table_size> table = {};
+        for (std::size_t k = 0; k < keyword_count; ++k)
+            table[KeywordHash(keywordNames[k], keyword_seed)] = static_cast<Keyword>(k + 1);
+        return table;
+    }
+    constexpr auto keyword_table = KeywordTable();
+
+    constexpr std::size_t MinKeywordLength()
+    {
+        std::size_t result = keywordNames[0].size();
+        for (auto name: keywordNames)
+            result = name.size() < result ? name.size() : result;
+        return result;
+    }
+    constexpr std::size_t MaxKeywordLength()
+    {
+        std::size_t result = 0;
+        for (auto name: keywordNames)
+            result = name.size() > result ? name.size() : result;
+        return result;
+    }
+} // detail
+
+// returns Keyword::none if id is not a keyword
+constexpr Keyword FindKeyword(std::string_view id)
+{
+    if (id.size() < detail::MinKeywordLength() || id.size() > detail::MaxKeywordLength())
+        return Keyword::none;
+    const Keyword k = detail::keyword_table[detail::KeywordHash(id, detail::keyword_seed)];
+    return (k != Keyword::none && Name(k) == id) ? k : Keyword::none;
+}
+
+static_assert(FindKeyword("return") == Keyword::return_ && FindKeyword("float") == Keyword::float_ &&
+              FindKeyword("main") == Keyword::none, "wrong keyword table");
+
+#endif // KEYWORDS_H_
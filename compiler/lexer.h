@@ -0,0 +1,377 @@
+// Lexical analysis for dcc: tokens, lexical errors and the two token sources.
+
+#ifndef LEXER_H_
+#define LEXER_H_
+
+#include <cctype>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include "keywords.h"
+
+namespace detail
+{
+    inline std::string FormatMsg(const std::string& msg, std::size_t line, std::size_t col)
+    {
+        std::ostringstream oss;
+        oss << "Line " << line << ", col " << col << ": " << msg;
+        return oss.str();
+    }
+} // detail
+
+/** Base class for all compiler errors. Derives from
+* @c std::runtime_error. Call member function @c what to get human
+* readable message associated with the error.
+*/
+class CompilerError : public std::runtime_error
+{
+public:
+    /** Instantiate a CompilerError instance with the given message.
+    * @param what The message to associate with this error.
+    */
+    CompilerError( const std::string &what ) :
+        std::runtime_error( what )
+    {
+    }
+
+    ~CompilerError() throw()
+    {
+    }
+};
+
+/** Error indicating a lexical error scanning a configuration.
+*   Derives from CompilerError.
+*/
+class LexicalError : public CompilerError
+{
+public:
+    LexicalError(const std::string& msg, std::size_t line, std::size_t col) :
+        CompilerError(detail::FormatMsg(msg, line, col)) {}
+};
+
+/** Error indicating a syntax error parsing a configuration.
+*   Derives from CompilerError.
+*/
+class SyntaxError : public CompilerError
+{
+public:
+    /// Instantiate a SyntaxError
+    SyntaxError(const std::string& msg, std::size_t line, std::size_t col) :
+        CompilerError(detail::FormatMsg(msg, line, col)) {}
+};
+
+// Represent a token.
+// The lexem is a view: it points either into the source buffer
+// (BufferedTokenSource) or into the token source itself (TokenSource),
+// so it's valid only until the next call to Next() on the source.
+struct Token
+{
+    // terminals
+    enum Type {
+        keyword,           // return, int, float ...
+        identifier,        // <id>     [a-zA-Z_] [a-zA-Z0-9_:<>]*
+        open_parenthesis,  // (
+        close_parenthesis, // )
+        open_brace,        // {
+        close_brace,       // }
+        semicolon,         // ;
+        assign,            // =
+        int_literal,       // [0-9]+
+        char_literal,      // '.'
+        string_literal,    // ".*"
+        operator_,         // +, -, *, /, ~, !
+        done               // EOF
+    };
+    Type type;
+    std::string_view lexem;
+    Keyword keywordValue = Keyword::none; // only for keyword
+    Token(Type t, std::string_view l = {}) : type( t ), lexem( l ) {}
+    // a keyword or an identifier, depending on the lexem
+    static Token Word(std::string_view l)
+    {
+        Token result(Token::identifier, l);
+        result.keywordValue = FindKeyword(l);
+        if (result.keywordValue != Keyword::none)
+            result.type = Token::keyword;
+        return result;
+    }
+    // return a string explaining the type of a token
+    static std::string Description( Type t )
+    {
+        switch ( t )
+        {
+            case keyword: return "<keyword>"; break;
+            case identifier: return "<identifier>"; break;
+            case open_parenthesis: return "("; break;
+            case close_parenthesis: return ")"; break;
+            case open_brace: return "{"; break;
+            case close_brace: return "}"; break;
+            case semicolon: return ";"; break;
+            case assign: return "="; break;
+            case int_literal: return "<int_literal>"; break;
+            case char_literal: return "<char_literal>"; break;
+            case string_literal: return "<string_literal>"; break;
+            case operator_: return "<operator>"; break;
+            case done: return "<EOF>"; break;
+        }
+        return "???"; // can't reach this point
+    }
+};
+
+// Split an input stream into a sequence of token.
+// Each call at Split::Next method returns the next token
+// (or throws a LexicalError if the next token is unknown).
+class TokenSource
+{
+public:
+    explicit TokenSource(std::istream& in) : input(in), lineno(1), column(1) {}
+    // throw LexicalError
+    Token Next()
+    {
+        while ( true )
+        {
+            char c = input.peek();
+            switch ( c )
+            {
+                case ' ': case '\t': Consume(); break;
+                case '\n': NewLine(); Consume(); break;
+                case '(': Consume(); return Token( Token::open_parenthesis ); break;
+                case ')': Consume(); return Token( Token::close_parenthesis ); break;
+                case '{': Consume(); return Token( Token::open_brace ); break;
+                case '}': Consume(); return Token( Token::close_brace ); break;
+                case ';': Consume(); return Token( Token::semicolon ); break;
+                case '=': Consume(); return Token( Token::assign ); break;
+                case '-':
+                case '+':
+                case '*':
+                case '/':
+                case '~':
+                case '!':
+                    Consume();
+                    lexem.assign( 1, c );
+                    return Token( Token::operator_, lexem );
+                    break;
+                case '\'':
+                    {
+                        Consume(); // '
+                        c = input.peek();
+                        // TODO manage quoted chars
+                        Consume(); // char
+                        if ( input.peek() == '\'' ) Consume(); // '
+                        else throw LexicalError( "Missing terminating char closing", lineno, column );
+                        lexem.assign( 1, c );
+                        return Token( Token::char_literal, lexem );
+                    }
+                    break;
+                case '"':
+                    {
+                        lexem.clear();
+                        Consume();
+                        c = input.peek();
+                        while ( c != '"' && !input.eof() && c != '\n' )
+                        {
+                            lexem += c;
+                            Consume();
+                            c = input.peek();
+                        }
+                        if ( c == '"' ) Consume();
+                        else throw LexicalError( "Missing terminating string closing", lineno, column );
+                        return Token( Token::string_literal, lexem );
+                    }
+                    break;
+                default:
+                {
+                    if ( isalpha( c ) || c == '_' )
+                    {
+                        lexem.clear();
+                        while ( isalnum( c ) || c == '_' || c == ':' || c == '<' || c == '>' )
+                        {
+                            lexem += c;
+                            Consume();
+                            c = input.peek(); // next char...
+                        }
+                        return Token::Word(lexem);
+                    }
+                    else if ( input.eof() )
+                        return Token( Token::done );
+                    else if ( isdigit( c ) || c == '-' || c == '+' )
+                    {
+                        std::size_t sepcount = 0;
+
+                        lexem.assign( 1, c );
+                        Consume();
+                        c = input.peek(); // next char...
+
+                        while ( isdigit( c ) || c == '.' )
+                        {
+                            if ( c == '.' )
+                                if ( ++sepcount > 1 )
+                                    throw LexicalError( "Floating point invalid (too many '.')", lineno, column );
+                            lexem += c;
+                            Consume();
+                            c = input.peek(); // next char...
+                        }
+                        return Token( Token::int_literal, lexem );
+                    }
+                    else
+                        throw LexicalError( "Unrecognized character", lineno, column );
+                }
+            }
+        }
+    }
+
+    std::size_t Line() const { return lineno; }
+    std::size_t Col() const { return column; }
+
+private:
+    void NewLine()
+    {
+        ++lineno;
+        column = 1;
+    }
+    void Consume()
+    {
+        input.get();
+        ++column;
+    }
+    std::istream& input;
+    std::string lexem; // storage for the lexem of the last token returned
+    std::size_t lineno;
+    std::size_t column;
+};
+
+// Read the whole content of a file in a single block.
+// Throws CompilerError if the file cannot be read.
+inline std::string ReadFile(const std::string& fileName)
+{
+    std::ifstream in(fileName, std::ios::binary);
+    if (!in)
+        throw CompilerError("File " + fileName + " not found");
+    in.seekg(0, std::ios::end);
+    const auto size = in.tellg();
+    in.seekg(0, std::ios::beg);
+    std::string content(static_cast<std::size_t>(size), '\0');
+    if (!in.read(&content[0], size))
+        throw CompilerError("Error reading file " + fileName);
+    return content;
+}
+
+// Split a memory buffer into a sequence of token,
+// like TokenSource does with a stream.
+// The tokens returned are slices of the buffer, so it must outlive them.
+// The line is updated only at newlines and the column is computed
+// from the start of the current line, so scanning a character costs
+// just a pointer increment.
+class BufferedTokenSource
+{
+public:
+    explicit BufferedTokenSource(std::string_view buffer) :
+        current(buffer.data()), end(buffer.data() + buffer.size()),
+        lineStart(current), lineno(1)
+    {}
+    // throw LexicalError
+    Token Next()
+    {
+        while ( current != end )
+        {
+            const char* begin = current;
+            switch ( *current )
+            {
+                case ' ': case '\t': ++current; break;
+                case '\n': ++current; NewLine(); break;
+                case '(': ++current; return Token( Token::open_parenthesis ); break;
+                case ')': ++current; return Token( Token::close_parenthesis ); break;
+                case '{': ++current; return Token( Token::open_brace ); break;
+                case '}': ++current; return Token( Token::close_brace ); break;
+                case ';': ++current; return Token( Token::semicolon ); break;
+                case '=': ++current; return Token( Token::assign ); break;
+                case '-':
+                case '+':
+                case '*':
+                case '/':
+                case '~':
+                case '!':
+                    ++current;
+                    return Token( Token::operator_, Slice(begin) );
+                    break;
+                case '\'':
+                    {
+                        ++current; // '
+                        // TODO manage quoted chars
+                        if ( current != end ) ++current; // char
+                        if ( current != end && *current == '\'' ) ++current; // '
+                        else throw LexicalError( "Missing terminating char closing", Line(), Col() );
+                        return Token( Token::char_literal, std::string_view( begin + 1, 1 ) );
+                    }
+                    break;
+                case '"':
+                    {
+                        ++current;
+                        while ( current != end && *current != '"' && *current != '\n' )
+                            ++current;
+                        if ( current == end || *current != '"' )
+                            throw LexicalError( "Missing terminating string closing", Line(), Col() );
+                        ++current;
+                        return Token( Token::string_literal, std::string_view( begin + 1, current - begin - 2 ) );
+                    }
+                    break;
+                default:
+                {
+                    const unsigned char c = *current;
+                    if ( IsIdStart( c ) )
+                    {
+                        while ( current != end && IsIdChar( *current ) )
+                            ++current;
+                        return Token::Word(Slice(begin));
+                    }
+                    else if ( isdigit( c ) )
+                    {
+                        std::size_t sepcount = 0;
+                        ++current;
+                        while ( current != end && ( isdigit( static_cast<unsigned char>(*current) ) || *current == '.' ) )
+                        {
+                            if ( *current == '.' )
+                                if ( ++sepcount > 1 )
+                                    throw LexicalError( "Floating point invalid (too many '.')", Line(), Col() );
+                            ++current;
+                        }
+                        return Token( Token::int_literal, Slice(begin) );
+                    }
+                    else
+                        throw LexicalError( "Unrecognized character", Line(), Col() );
+                }
+            }
+        }
+        return Token( Token::done );
+    }
+
+    std::size_t Line() const { return lineno; }
+    std::size_t Col() const { return current - lineStart + 1; }
+
+private:
+    static bool IsIdStart(unsigned char c)
+    {
+        return isalpha( c ) || c == '_';
+    }
+    static bool IsIdChar(unsigned char c)
+    {
+        return isalnum( c ) || c == '_' || c == ':' || c == '<' || c == '>';
+    }
+    void NewLine()
+    {
+        ++lineno;
+        lineStart = current;
+    }
+    std::string_view Slice(const char* begin) const
+    {
+        return std::string_view( begin, current - begin );
+    }
+    const char* current;
+    const char* const end;
+    const char* lineStart;
+    std::size_t lineno;
+};
+
+#endif // LEXER_H_
@@ -5,638 +5,414 @@
 #include <string>
 #include <sstream>
 #include <vector>
+#include <memory>
+#include <cassert>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <cstdlib>
+#include <new>
 #include <boost/filesystem.hpp>
+#include "lexer.h"
+#include "parser.h"
+#include "ast.h"
+#include "regalloc.h"
+#include "interpreter.h"
+#include "ir.h"
+#include "ir_passes.h"
+#include "ir_emitter.h"
+#include "x86.h"
+#include "elf.h"
+#include "time_report.h"
+#include "cache.h"
 
-namespace detail
-{
-    inline std::string FormatMsg(const std::string& msg, std::size_t line, std::size_t col)
-    {
-        std::ostringstream oss;
-        oss << "Line " << line << ", col " << col << ": " << msg;
-        return oss.str();
-    }
-} // detail
-
-/** Base class for all compiler errors. Derives from
-* @c std::runtime_error. Call member function @c what to get human
-* readable message associated with the error.
-*/
-class CompilerError : public std::runtime_error
-{
-public:
-    /** Instantiate a CompilerError instance with the given message.
-    * @param what The message to associate with this error.
-    */
-    CompilerError( const std::string &what ) : 
-        std::runtime_error( what ) 
-    {
-    }
+using namespace std;
 
-    ~CompilerError() throw()
-    {
-    }
-};
+/////////////////////////////////////////////////////////////
 
-/** Error indicating a lexical error scanning a configuration.
-*   Derives from CompilerError.
-*/
-class LexicalError : public CompilerError
+/*
+class AST
 {
-public:
-    LexicalError(const std::string& msg, std::size_t line, std::size_t col) :
-        CompilerError(detail::FormatMsg(msg, line, col)) {}
 };
 
-/** Error indicating a syntax error parsing a configuration.
-*   Derives from CompilerError.
-*/
-class SyntaxError : public CompilerError
+std::unique_ptr<AST> Parse(const std::string& inputFile)
 {
-public:
-    /// Instantiate a SyntaxError
-    SyntaxError(const std::string& msg, std::size_t line, std::size_t col) :
-        CompilerError(detail::FormatMsg(msg, line, col)) {}
-};
+    auto ast = std::make_unique<AST>();
+    return ast;
+}
 
-// Represent a token
-struct Token
+std::string GenerateAsm(std::unique_ptr<AST> ast)
 {
-    // terminals
-    enum Type { 
-        keyword,           // return, int, float ...
-        identifier,        // <id>     [a-zA-Z_] [a-zA-Z0-9_:<>]*
-        open_parenthesis,  // (
-        close_parenthesis, // )
-        open_brace,        // {
-        close_brace,       // }
-        semicolon,         // ;
-        assign,            // =
-        int_literal,       // [0-9]+
-        char_literal,      // '.'
-        string_literal,    // ".*"
-        operator_,         // +, -, *, /, ~, !
-        done               // EOF
-    };
-    Type type;
-    std::string lexem;
-    Token(Type t, const std::string& l = {}) : type( t ), lexem( l ) {}
-    Token(Type t, char c) : type( t ), lexem(1,c) {}
-    // return a string explaining the type of a token
-    static std::string Description( Type t )
-    {
-        switch ( t )
-        {
-            case keyword: return "<keyword>"; break;
-            case identifier: return "<identifier>"; break;
-            case open_parenthesis: return "("; break;
-            case close_parenthesis: return ")"; break;
-            case open_brace: return "{"; break;
-            case close_brace: return "}"; break;
-            case semicolon: return ";"; break;
-            case assign: return "="; break;
-            case int_literal: return "<int_literal>"; break;
-            case char_literal: return "<char_literal>"; break;
-            case string_literal: return "<string_literal>"; break;
-            case operator_: return "<operator>"; break;
-            case done: return "<EOF>"; break;
-        }
-        return "???"; // can't reach this point
-    }
+    const std::string funcName = "main";
+    const std::string retValue = "42";
 
-    static const std::vector<std::string> keywords;
-};
+    const std::string asmContent =
+        ".globl " + funcName + "\n"
+        "" + funcName + ":\n"
+        "movl $" + retValue + ", %eax\n"
+        "ret\n";
 
-const std::vector<std::string> Token::keywords = { "return", "int", "float" };
+    return asmContent;
+}
+*/
 
-// Split an input stream into a sequence of token.
-// Each call at Split::Next method returns the next token
-// (or throws a LexicalError if the next token is unknown).
-class TokenSource
+// Read all the tokens, without parsing
+template <typename Source>
+void Lex(Source input)
 {
-public:
-    explicit TokenSource(std::istream& in) : input(in), lineno(1), column(1) {}
-    // throw LexicalError
-    Token Next()
+    while (input.Next().type != Token::done)
+        ;
+}
+
+// Parse fileName using the token source selected:
+// the buffered one reads the whole file with a single read and
+// scans it in memory, the stream one reads a char at a time.
+// The tree is allocated in arena.
+// If report is not null, the source is first scanned by the token source
+// alone to measure the lexing: Grammar::Parse interleaves it with the parsing.
+AST::Node* Parse(const std::string& fileName, bool streamLexer, Arena& arena, TimeReport* report = nullptr)
+{
+    if (streamLexer)
     {
-        while ( true )
+        if (report != nullptr)
         {
-            char c = input.peek();
-            switch ( c )
-            {
-                case ' ': case '\t': Consume(); break;
-                case '\n': NewLine(); Consume(); break;
-                case '(': Consume(); return Token( Token::open_parenthesis ); break;
-                case ')': Consume(); return Token( Token::close_parenthesis ); break;
-                case '{': Consume(); return Token( Token::open_brace ); break;
-                case '}': Consume(); return Token( Token::close_brace ); break;
-                case ';': Consume(); return Token( Token::semicolon ); break;
-                case '=': Consume(); return Token( Token::assign ); break;
-                case '-':
-                case '+':
-                case '*':
-                case '/':
-                case '~':
-                case '!': 
-                    Consume(); 
-                    return Token( Token::operator_, c ); 
-                    break;
-                case '\'': 
-                    {
-                        Consume(); // '
-                        c = input.peek();
-                        // TODO manage quoted chars
-                        Consume(); // char
-                        if ( input.peek() == '\'' ) Consume(); // '
-                        else throw LexicalError( "Missing terminating char closing", lineno, column );
-                        return Token( Token::char_literal, std::string( 1, c ) );
-                    }
-                    break;
-                case '"':
-                    {
-                        std::string value;
-                        Consume();
-                        c = input.peek();
-                        while ( c != '"' && !input.eof() && c != '\n' )
-                        {
-                            value += c;
-                            Consume();
-                            c = input.peek();
-                        }
-                        if ( c == '"' ) Consume();
-                        else throw LexicalError( "Missing terminating string closing", lineno, column );
-                        return Token( Token::string_literal, value );
-                    }
-                    break;
-                default:
-                {
-                    if ( isalpha( c ) || c == '_' )
-                    {
-                        std::string id;
-                        while ( isalnum( c ) || c == '_' || c == ':' || c == '<' || c == '>' )
-                        {
-                            id += c;
-                            Consume();
-                            c = input.peek(); // next char...
-                        }
-                        if (std::find(Token::keywords.begin(), Token::keywords.end(), id) != Token::keywords.end())
-                            return Token(Token::keyword, id);
-                        else return Token( Token::identifier, id );
-                    }
-                    else if ( input.eof() )
-                        return Token( Token::done );
-                    else if ( isdigit( c ) || c == '-' || c == '+' )
-                    {
-                        std::string num;
-                        std::size_t sepcount = 0;
-
-                        num += c;
-                        Consume();
-                        c = input.peek(); // next char...
-
-                        while ( isdigit( c ) || c == '.' )
-                        {
-                            if ( c == '.' ) 
-                                if ( ++sepcount > 1 )
-                                    throw LexicalError( "Floating point invalid (too many '.')", lineno, column );
-                            num += c;
-                            Consume();
-                            c = input.peek(); // next char...
-                        }
-                        return Token( Token::int_literal, num );
-                    }
-                    else
-                        throw LexicalError( "Unrecognized character", lineno, column );
-                }
-            }
+            TimeReport::Scope scope(report, "lex");
+            std::ifstream input(fileName);
+            if (input)
+                Lex(TokenSource(input));
         }
+        TimeReport::Scope scope(report, "parse");
+        std::ifstream input(fileName);
+        if (!input)
+            throw CompilerError("File " + fileName + " not found");
+        Grammar<TokenSource> grammar(TokenSource(input), arena);
+        return grammar.Parse();
     }
-
-    std::size_t Line() const { return lineno; }
-    std::size_t Col() const { return column; }
-
-private:
-    void NewLine()
+    std::string source;
     {
-        ++lineno;
-        column = 1;
+        TimeReport::Scope scope(report, "read");
+        source = ReadFile(fileName);
     }
-    void Consume()
+    if (report != nullptr)
     {
-        input.get();
-        ++column;
+        TimeReport::Scope scope(report, "lex");
+        Lex(BufferedTokenSource(source));
     }
-    std::istream& input;
-    std::size_t lineno;
-    std::size_t column;
-};
-
-/////////////////////////////////////////////////////////////
+    TimeReport::Scope scope(report, "parse");
+    Grammar<BufferedTokenSource> grammar(BufferedTokenSource(source), arena);
+    return grammar.Parse();
+}
 
-using namespace std;
+// The heap allocations are counted for --time-report.
+// gcc warns about free on memory of operator new, not knowing it's malloc.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void* operator new(std::size_t size)
+{
+    AllocationCounter::Add(size);
+    if (void* p = std::malloc(size == 0 ? 1 : size))
+        return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
 
-namespace AST
+struct Options
 {
-    class Node
-    {
-    public:
-        virtual ~Node() = default;
-        virtual void Emit(ostream& out) = 0;
-    };
+    bool streamLexer = false;
+    bool fold = true;
+    std::string backend = "stack";
+    bool irPasses = true;
+    bool dumpIR = false;
+    bool interpret = false;
+    bool object = false; // write the .o file, instead of the .s
+    std::string timeReport; // "", "text" or "json"
+    std::string cacheDirectory; // no cache if empty
+    std::uintmax_t cacheSize = 100 * 1024 * 1024;
+    bool cacheStats = false;
+    bool verbose = true;
+    unsigned jobs = 0; // 0 means one for each core
+};
 
-    class IntLiteral : public Node
+// Compile a file generating the .s (or .o) file next to it.
+// The arena is reset at the end, so that the caller can reuse it.
+// Returns the messages for the user, throws CompilerError on errors.
+// If report is not null, it gets the measures of the phases.
+// If cache is not null, the output is taken from it, when there.
+std::string Compile(std::string fileName, const Options& options, Arena& arena,
+                    TimeReport* report = nullptr, CompilationCache* cache = nullptr)
+{
+    struct ResetArena
     {
-    public:
-        explicit IntLiteral(const string& _value) : value(_value) {}
-        void Emit(ostream& out) override { out << "movl $" << value << ", %eax\n"; }
-    private:
-        const string value;
-    };
-
-    class Return : public Node
+        ~ResetArena() { arena.Reset(); }
+        Arena& arena;
+    } resetArena{ arena };
+
+    std::ostringstream messages;
+
+    if ( boost::filesystem::extension(fileName) != ".c" )
+        throw CompilerError("Only files with extension .c are allowed");
+
+    // the options that change the output
+    std::ostringstream outputOptions;
+    outputOptions << "dcc 1" << " fold=" << options.fold << " backend=" << options.backend
+                  << " ir-passes=" << options.irPasses << " object=" << options.object;
+    const auto output = boost::filesystem::change_extension(fileName, options.object ? ".o" : ".s").string();
+
+    // the interpreter and the IR dump need the tree
+    if (options.interpret || options.dumpIR)
+        cache = nullptr;
+    std::string key;
+    if (cache != nullptr)
     {
-    public:
-        explicit Return(unique_ptr<Node> _exp) : exp(move(_exp)) {}
-        void Emit(ostream& out) override
-        { 
-            exp->Emit(out);
-            out << "ret\n";
-        }
-    private:
-        unique_ptr<Node> exp;
-    };
-
-    class UnaryOperation : public Node
-    {
-    public:
-        UnaryOperation(const string& op, unique_ptr<Node> _innerExpression) : 
-            operation(op), innerExpression(move(_innerExpression)) {}
-        void Emit(ostream& out) override
+        TimeReport::Scope scope(report, "cache lookup");
+        key = CompilationCache::Key(ReadFile(fileName), outputOptions.str());
+        if (cache->Fetch(key, output))
         {
-            innerExpression->Emit(out);
-            if (operation == "-")
-            {
-                out << "neg %eax\n";
-            }
-            else if (operation == "~")
-            {
-                out << "not %eax\n";                
-            }
-            else if (operation == "!")
-            {
-                out << "cmpl $0, %eax\n";
-                out << "movl $0, %eax\n";
-                out << "sete %al\n";
-            }
-            else
-                assert(false);
-
+            if (options.verbose)
+                messages << "Found in cache\n";
+            return messages.str();
         }
-    private:
-        const string operation;
-        unique_ptr<Node> innerExpression;
-    };
-
-    class BinaryOp : public Node
-    {
-    public:
-        BinaryOp(const string& op, unique_ptr<Node> _leftExp, unique_ptr<Node> _rightExp) : 
-            operation(op), leftExp(move(_leftExp)), rightExp(move(_rightExp)) {}
-        void Emit(ostream& out) override
-        {
-            if (operation == "*")
-            {
-                leftExp->Emit(out);
-                out << "push %eax\n";
-                rightExp->Emit(out);
-                out << "pop %ecx\n";
-                out << "imul %ecx, %eax\n";
-            }
-            else if (operation == "/")
-            {
-                out << "xor %edx, %edx\n"; // 0 -> EDX
-                rightExp->Emit(out); // rhs -> EAX
-                out << "push %eax\n";
-                leftExp->Emit(out); // lhs -> EAX
-                out << "pop %ecx\n";                
-                out << "idivl %ecx\n"; // EDX:EAX / ECX -> EAX
-            }
-            else if (operation == "+")
-            {
-                leftExp->Emit(out);
-                out << "push %eax\n";
-                rightExp->Emit(out);
-                out << "pop %ecx\n";
-                out << "addl %ecx, %eax\n";
-            }
-            else if (operation == "-")
-            {
-                rightExp->Emit(out);
-                out << "push %eax\n";                
-                leftExp->Emit(out); // eax = lhs
-                out << "pop %ecx\n"; // ecx = lrs                
-                out << "subl %ecx, %eax\n"; // subl src, dst -> dst=dst-src   eax=eax-ecx
-            }
-            else
-                assert(false);
-
-        }
-    private:
-        const string operation;
-        unique_ptr<Node> leftExp;
-        unique_ptr<Node> rightExp;
-    };
-
-    class Function : public Node
-    {
-    public:
-        Function(const string& _funcName, unique_ptr<Node> _body) : funcName(_funcName), body(move(_body)) {}
-        void Emit(ostream& out) override
-        { 
-            out <<
-                ".globl " + funcName + "\n"
-                "" + funcName + ":\n";
-            body->Emit(out);
-        }
-    private:
-        const string funcName;
-        unique_ptr<Node> body;
-    };
-};
-
-////////////////////////////////////////////////////////////////////
-
-/*
-
-GRAMMAR
-
-<program> ::= <function>
-<function> ::= "int" <id> "(" ")" "{" <statement> "}"
-<statement> ::= "return" <exp> ";"
-<exp> ::= <term> { ("+" | "-") <term> }
-<term> ::= <factor> { ("*" | "/") <factor> }
-<factor> ::= "(" <exp> ")" | <unary_op> <factor> | <int_literal>
-<unary_op> ::= "!" | "~" | "-"
-
-*/
-
-class Grammar
-{
-public:
-    using NodePtr = unique_ptr<AST::Node>;
-
-    explicit Grammar(std::istream& in) : 
-        input(in), lookahead(Token::done)
-    {}
+    }
+    auto ast = Parse(fileName, options.streamLexer, arena, report);
 
-    // throws SyntaxError
-    // <program> ::= <function>
-    // <function> ::= "int" <id> "(" ")" "{" <statement> "}"
-    NodePtr Parse()
+    if (options.interpret) // print the value returned, without generating code
     {
-        lookahead = input.Next();
-        Match(Token::keyword);
-        const std::string funName = NextLexem();
-        Match(Token::identifier);
-        Match(Token::open_parenthesis);
-        Match(Token::close_parenthesis);
-        Match(Token::open_brace);
-        auto stmt = Statement();
-        Match(Token::close_brace);
-        Match(Token::done);
-        return make_unique<AST::Function>(funName, move(stmt));
+        messages << Interpreter().Run(*ast) << "\n";
+        return messages.str();
     }
-private:
 
-    // <statement> ::= "return" <exp> ";"
-    NodePtr Statement()
+    //actions.Epilogue();
+    if (options.verbose)
+        messages << "End Parsing\n";
+
+    if (options.fold)
     {
-        const std::string returnKeyword = NextLexem();
-        if (returnKeyword != "return")
-            throw SyntaxError( "expecting return, got " + returnKeyword, input.Line(), input.Col() );
-        Match(Token::keyword);
-        auto exp = Expression();
-        Match(Token::semicolon);
-        return make_unique<AST::Return>(move(exp));
+        TimeReport::Scope scope(report, "fold");
+        ast = ast->Fold(arena);
     }
 
-    // <exp> ::= <term> { ("+" | "-") <term> }
-    NodePtr Expression()
+    if (options.object)
     {
-        auto term = Term();
-        auto next = NextLexem();
-        while (next == "+" || next == "-") // more terms
+        X86::Function function;
         {
-            Match(Token::operator_);
-            auto nextTerm = Term();
-            term = make_unique<AST::BinaryOp>(next, move(term), move(nextTerm));
-            next = NextLexem();                    
+            TimeReport::Scope scope(report, "emit");
+            function = X86::CodeGenerator().Generate(*ast);
         }
-        return term;
+        TimeReport::Scope scope(report, "write object");
+        std::ofstream out(output, std::ios::binary);
+        ELF::WriteObject(out, function.name, function.code);
+        out.close();
+        if (!out)
+            throw CompilerError("Error writing " + output);
+        if (cache != nullptr)
+            cache->Store(key, output);
+        return messages.str();
     }
 
-    // <term> ::= <factor> { ("*" | "/") <factor> }
-    NodePtr Term()
+    std::ofstream out(output);
+
+    if (options.backend == "registers")
     {
-        auto factor = Factor();
-        auto next = NextLexem();
-        while (next == "*" || next == "/") // more factors
-        {
-            Match(Token::operator_);
-            auto nextFactor = Factor();
-            factor = make_unique<AST::BinaryOp>(next, move(factor), move(nextFactor));
-            next = NextLexem();        
-        }
-        return factor;
+        TimeReport::Scope scope(report, "emit");
+        RegisterEmitter(out).Emit(*ast);
     }
-
-    // <factor> ::= "(" <exp> ")" | <unary_op> <factor> | <int_literal>
-    // <unary_op> ::= "!" | "~" | "-"    
-    NodePtr Factor()
+    else if (options.backend == "ir")
     {
-        switch (lookahead.type)
+        IR::Function function;
         {
-            case Token::int_literal:
-            {
-                const std::string intLiteral = NextLexem();
-                Match(Token::int_literal);
-                return make_unique<AST::IntLiteral>(intLiteral);
-                break;
-            }
-            case Token::operator_:
-            {
-                const std::string operation = NextLexem();            
-                if ( (operation != "-") && (operation != "~") && (operation != "!") ) // check for unary operators
-                    throw SyntaxError( "Expecting unary operator. Got " + operation, input.Line(), input.Col() );
-                Match(Token::operator_);
-                auto innerFact = Factor();
-                return make_unique<AST::UnaryOperation>(operation, move(innerFact));
-                break;
-            }
-            case Token::open_parenthesis:
+            TimeReport::Scope scope(report, "lower");
+            function = IR::Lowering().Lower(*ast);
+        }
+        if (options.irPasses)
+        {
+            for (const auto& pass: IR::passes)
             {
-                Match(Token::open_parenthesis);
-                auto innerExp = Expression();
-                Match(Token::close_parenthesis);
-                return innerExp;
-                break;
+                TimeReport::Scope scope(report, pass.name);
+                pass.run(function);
             }
-            default:
-                throw SyntaxError( "Expecting int literal, unary operator or (. Got " + Token::Description(lookahead.type), input.Line(), input.Col() );                    
         }
+        if (options.dumpIR)
+            IR::Print(messages, function);
+        TimeReport::Scope scope(report, "emit");
+        IR::Emitter(out).Emit(function);
     }
-
-#if 0
-    // loadexpr -> <load> <value>
-    void LoadExpr()
+    else
     {
-        Match( Token::load );
-        const std::string value = NextLexem();
-        Match( Token::value );
-        actions.Load( value );
+        TimeReport::Scope scope(report, "emit");
+        ast->Emit(out);
     }
-    // assignexpr     ->  <id> <assign> <create> <id> <optparamlist> | <id> depexpr
-    // optparamlist   ->  <empty> | <open> attrlist <close>
-    // attrlist       ->  <empty> | attrassign moreattrassign
-    // attrassign     ->  <id> <assign> <value>
-    // moreattrassign ->  <empty> | <attrsep> attrassign    
-    // depexpr        ->  <collsep> <id> <assign> <id>
-    void AssignExpr()
+
+    out.close();
+    if (!out)
+        throw CompilerError("Error writing " + output);
+    if (cache != nullptr)
+        cache->Store(key, output);
+    return messages.str();
+}
+
+// Compile the files in parallel: each thread takes the next file not yet
+// compiled, until there are no more, with its own parser and arena.
+// The messages are printed in the order of the files at the end.
+// Returns false if the compilation of any file failed.
+bool CompileAll(const std::vector<std::string>& files, const Options& options)
+{
+    std::vector<std::string> messages(files.size());
+    std::vector<char> failed(files.size(), false);
+    std::vector<TimeReport> reports;
+    for (const auto& f: files)
+        reports.emplace_back(f);
+    const bool timeReport = !options.timeReport.empty();
+    std::unique_ptr<CompilationCache> cache;
+    if (!options.cacheDirectory.empty())
+        cache = std::make_unique<CompilationCache>(options.cacheDirectory, options.cacheSize);
+    std::atomic<std::size_t> next(0);
+
+    auto worker = [&]()
     {
-        const std::string lvalue = NextLexem();
-        Match( Token::id );
-        switch ( lookahead.type )
+        Arena arena; // reused for all the files compiled by this thread
+        for (std::size_t i = next++; i < files.size(); i = next++)
         {
-            case Token::assign:
+            try
             {
-                Match( Token::assign );
-                Match( Token::create );
-                const std::string rvalue = NextLexem();
-                Match( Token::id );
-                if ( lookahead.type == Token::open )
-                {
-                    Match( Token::open );
-                    while ( lookahead.type == Token::id )
-                    {
-                        const std::string attId = NextLexem();
-                        Match( Token::id );
-                        Match( Token::assign );
-                        const std::string attValue = NextLexem();
-                        Match( Token::value );
-                        actions.AssignAttribute( lvalue, attId, attValue );
-                        if ( lookahead.type == Token::attrsep ) Match( Token::attrsep );
-                    }
-                    Match( Token::close );
-                }
-                actions.Create( lvalue, rvalue );
-                break;
+                messages[i] = Compile(files[i], options, arena, timeReport ? &reports[i] : nullptr, cache.get());
             }
-            case Token::collsep:
+            catch (const std::exception& e)
             {
-                Match( Token::collsep );
-                const std::string dep = NextLexem();
-                Match( Token::id );
-                Match( Token::assign );
-                const std::string rvalue = NextLexem();
-                Match( Token::id );
-                actions.AssignDep( lvalue, dep, rvalue );
-                break;
+                messages[i] = files[i] + ": " + e.what() + "\n";
+                failed[i] = true;
             }
-            default:
-                throw SyntaxError( "expecting = or .", input.Line(), input.Col() ); // TODO
         }
+    };
+
+    unsigned jobs = options.jobs;
+    if (jobs == 0)
+        jobs = std::max(1u, std::thread::hardware_concurrency());
+    jobs = static_cast<unsigned>(std::min<std::size_t>(jobs, files.size()));
+
+    std::vector<std::thread> threads;
+    for (unsigned i = 1; i < jobs; ++i)
+        threads.emplace_back(worker);
+    worker(); // this thread works, as well
+    for (auto& t: threads)
+        t.join();
+
+    for (std::size_t i = 0; i < files.size(); ++i)
+    {
+        (failed[i] ? std::cerr : std::cout) << messages[i];
+        if (options.timeReport == "text" && !failed[i])
+            reports[i].Print(std::cout);
     }
-#endif
-    void Match( Token::Type t )
+    if (options.timeReport == "json")
     {
-        if ( lookahead.type == t ) lookahead = input.Next();
-        else throw SyntaxError( "expecting token " + Token::Description( t ) + ". Got " + Token::Description(lookahead.type), input.Line(), input.Col() ); // TODO error msg (e.g., "expecting t")
+        std::cout << "{\"files\": [";
+        bool first = true;
+        for (std::size_t i = 0; i < files.size(); ++i)
+        {
+            if (failed[i])
+                continue;
+            std::cout << (first ? "\n" : ",\n");
+            reports[i].PrintJson(std::cout);
+            first = false;
+        }
+        std::cout << "\n]}" << std::endl;
     }
-    std::string NextLexem() const
+    if (cache)
     {
-        return lookahead.lexem;
+        cache->Trim();
+        if (options.cacheStats)
+            cache->PrintStatistics(std::cout);
     }
-    TokenSource input;
-    Token lookahead;
-};
-
-/////////////////////////////////////////////////////////////
-
-/*
-class AST
-{
-};
-
-std::unique_ptr<AST> Parse(const std::string& inputFile)
-{
-    auto ast = std::make_unique<AST>();
-    return ast;
+    return std::find(failed.begin(), failed.end(), true) == failed.end();
 }
 
-std::string GenerateAsm(std::unique_ptr<AST> ast)
+// Read the file names listed in a response file, one for each line
+void ReadResponseFile(const std::string& fileName, std::vector<std::string>& files)
 {
-    const std::string funcName = "main";
-    const std::string retValue = "42";
-
-    const std::string asmContent =
-        ".globl " + funcName + "\n"
-        "" + funcName + ":\n"
-        "movl $" + retValue + ", %eax\n"
-        "ret\n";
-
-    return asmContent;
+    std::ifstream in(fileName);
+    if (!in)
+        throw CompilerError("Response file " + fileName + " not found");
+    std::string line;
+    while (std::getline(in, line))
+    {
+        const auto begin = line.find_first_not_of(" \t\r");
+        if (begin == std::string::npos)
+            continue;
+        const auto end = line.find_last_not_of(" \t\r");
+        files.push_back(line.substr(begin, end - begin + 1));
+    }
 }
-*/
 
 int main(int argc, char* argv[])
 {
     try
     {
-        if (argc != 2)
+        Options options;
+        std::vector<std::string> files;
+        for (int i = 1; i < argc; ++i)
         {
-            std::cerr << "No input file" << std::endl;
-            return 1;
+            const std::string arg = argv[i];
+            if (arg == "--stream-lexer")
+                options.streamLexer = true;
+            else if (arg == "--no-fold")
+                options.fold = false;
+            else if (arg == "--backend=stack" || arg == "--backend=registers" || arg == "--backend=ir")
+                options.backend = arg.substr(arg.find('=') + 1);
+            else if (arg == "--no-ir-passes")
+                options.irPasses = false;
+            else if (arg == "--dump-ir")
+                options.dumpIR = true;
+            else if (arg == "--interpret")
+                options.interpret = true;
+            else if (arg == "--time-report" || arg == "--time-report=text")
+                options.timeReport = "text";
+            else if (arg == "--time-report=json")
+                options.timeReport = "json";
+            else if (arg.compare(0, 8, "--cache=") == 0)
+                options.cacheDirectory = arg.substr(8);
+            else if (arg.compare(0, 13, "--cache-size=") == 0)
+                options.cacheSize = std::stoull(arg.substr(13)) * 1024 * 1024;
+            else if (arg == "--cache-stats")
+                options.cacheStats = true;
+            else if (arg == "--object")
+                options.object = true;
+            else if (arg.compare(0, 7, "--jobs=") == 0)
+                options.jobs = std::stoul(arg.substr(7));
+            else if (arg[0] == '@')
+                ReadResponseFile(arg.substr(1), files);
+            else if (arg[0] != '-')
+                files.push_back(arg);
+            else
+            {
+                std::cerr << "Usage: dcc [--stream-lexer] [--no-fold] [--backend=stack|registers|ir] [--no-ir-passes] [--dump-ir] [--interpret] [--object] [--time-report[=text|json]] [--cache=DIR [--cache-size=MB] [--cache-stats]] [--jobs=N] file.c... [@response_file]" << std::endl;
+                return 1;
+            }
         }
 
-        std::string fileName = argv[1];
-        
-        if ( boost::filesystem::extension(fileName) != ".c" )
+        if (files.empty())
         {
-            std::cerr << "Only files with extension .c are allowed" << std::endl;
+            std::cerr << "No input file" << std::endl;
             return 1;
         }
 
-        //
-        std::ifstream input(fileName);
-        if (!input)
+        if (options.object && options.backend != "stack")
         {
-            std::cerr << "File " << fileName << " not found" << std::endl;
+            std::cerr << "--object uses the code of the stack backend" << std::endl;
             return 1;
         }
-        Grammar grammar(input);
-        auto ast = grammar.Parse();
-        //actions.Epilogue();
-        std::cout << "End Parsing" << std::endl;
-
-        fileName = boost::filesystem::change_extension(fileName, ".s").string();
-        std::ofstream out(fileName);
 
-        ast->Emit(out);
-
-        // 
-
-        /*
-        auto ast = Parse(fileName);
-        
-        fileName = boost::filesystem::change_extension(fileName, ".s").string();
-
-        std::ofstream out(fileName);
-        out << GenerateAsm(std::move(ast));
-*/
+        options.verbose = (files.size() == 1 && options.timeReport != "json");
+        return CompileAll(files, options) ? 0 : 1;
     }
     catch (const std::exception& e)
     {
         std::cerr << "Exception:\n" << e.what() << std::endl;
     }
 
-    return 0;
+    return 1;
 }
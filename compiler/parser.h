@@ -0,0 +1,280 @@
+// Parser of dcc: recursive descent, with precedence climbing for the expressions.
+
+#ifndef PARSER_H_
+#define PARSER_H_
+
+#include <charconv>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "arena.h"
+#include "ast.h"
+#include "keywords.h"
+#include "lexer.h"
+
+/*
+
+GRAMMAR
+
+<program> ::= <function>
+<function> ::= "int" <id> "(" ")" "{" <statement> "}"
+<statement> ::= "return" <exp> ";"
+<exp> ::= <term> { ("+" | "-") <term> }
+<term> ::= <factor> { ("*" | "/") <factor> }
+<factor> ::= "(" <exp> ")" | <unary_op> <factor> | <int_literal>
+<unary_op> ::= "!" | "~" | "-"
+
+*/
+
+// Source is the token source: TokenSource or BufferedTokenSource.
+// The nodes of the tree are allocated in the arena passed.
+template <typename Source>
+class Grammar
+{
+public:
+    using NodePtr = AST::Node*;
+
+    Grammar(Source in, Arena& _arena) : 
+        input(std::move(in)), lookahead(Token::done), arena(_arena)
+    {}
+
+    // throws SyntaxError
+    // <program> ::= <function>
+    // <function> ::= "int" <id> "(" ")" "{" <statement> "}"
+    NodePtr Parse()
+    {
+        lookahead = input.Next();
+        Match(Keyword::int_);
+        const auto funName = arena.CopyString(NextLexem());
+        Match(Token::identifier);
+        Match(Token::open_parenthesis);
+        Match(Token::close_parenthesis);
+        Match(Token::open_brace);
+        auto stmt = Statement();
+        Match(Token::close_brace);
+        Match(Token::done);
+        return arena.Make<AST::Function>(funName, stmt);
+    }
+private:
+
+    // <statement> ::= "return" <exp> ";"
+    NodePtr Statement()
+    {
+        Match(Keyword::return_);
+        auto exp = Expression();
+        Match(Token::semicolon);
+        return arena.Make<AST::Return>(exp);
+    }
+
+    // <exp> ::= <term> { ("+" | "-") <term> }
+    // <term> ::= <factor> { ("*" | "/") <factor> }
+    // <factor> ::= "(" <exp> ")" | <unary_op> <factor> | <int_literal>
+    // <unary_op> ::= "!" | "~" | "-"
+    // Precedence climbing without recursion: the operators and the
+    // parentheses not yet reduced wait on an explicit stack, so the
+    // nesting depth is limited only by the memory.
+    // The tree and the errors are the ones of a recursive descent parser.
+    NodePtr Expression()
+    {
+        std::vector<Pending> pending;
+        std::vector<NodePtr> operands;
+
+        // the binary operations on top of the stack that bind at least as tight as precedence
+        const auto reduce = [&](int precedence)
+        {
+            while (!pending.empty() && pending.back().kind == Pending::binary &&
+                   Precedence(pending.back().binaryOp) >= precedence)
+            {
+                const auto right = operands.back();
+                operands.pop_back();
+                operands.back() = arena.Make<AST::BinaryOp>(pending.back().binaryOp, operands.back(), right);
+                pending.pop_back();
+            }
+        };
+
+        while (true)
+        {
+            // a factor: the unary operators and the parentheses before it
+            // wait for the operand
+            switch (lookahead.type)
+            {
+                case Token::int_literal:
+                {
+                    const auto intLiteral = IntValue(NextLexem());
+                    Match(Token::int_literal);
+                    operands.push_back(arena.Make<AST::IntLiteral>(intLiteral));
+                    break;
+                }
+                case Token::operator_:
+                {
+                    const auto operation = NextLexem();
+                    AST::UnaryOperator op;
+                    if (operation == "-") op = AST::UnaryOperator::negation;
+                    else if (operation == "~") op = AST::UnaryOperator::bitwise_complement;
+                    else if (operation == "!") op = AST::UnaryOperator::logical_negation;
+                    else // not an unary operator
+                        throw SyntaxError( "Expecting unary operator. Got " + std::string(operation), input.Line(), input.Col() );
+                    Match(Token::operator_);
+                    pending.push_back(Pending::Unary(op));
+                    continue;
+                }
+                case Token::open_parenthesis:
+                    Match(Token::open_parenthesis);
+                    pending.push_back(Pending::Parenthesis());
+                    continue;
+                default:
+                    throw SyntaxError( "Expecting int literal, unary operator or (. Got " + Token::Description(lookahead.type), input.Line(), input.Col() );
+            }
+
+            // after a factor: apply the unary operators, close the parentheses
+            // and look for the next binary operator
+            while (true)
+            {
+                while (!pending.empty() && pending.back().kind == Pending::unary)
+                {
+                    operands.back() = arena.Make<AST::UnaryOperation>(pending.back().unaryOp, operands.back());
+                    pending.pop_back();
+                }
+
+                AST::BinaryOperator op;
+                if (IsBinaryOperator(NextLexem(), op)) // more terms or factors
+                {
+                    Match(Token::operator_);
+                    reduce(Precedence(op));
+                    pending.push_back(Pending::Binary(op));
+                    break;
+                }
+
+                // the end of the innermost expression
+                reduce(0);
+                if (pending.empty())
+                    return operands.back();
+                Match(Token::close_parenthesis); // pending.back() is the "("
+                pending.pop_back();
+            }
+        }
+    }
+
+#if 0
+    // loadexpr -> <load> <value>
+    void LoadExpr()
+    {
+        Match( Token::load );
+        const std::string value = NextLexem();
+        Match( Token::value );
+        actions.Load( value );
+    }
+    // assignexpr     ->  <id> <assign> <create> <id> <optparamlist> | <id> depexpr
+    // optparamlist   ->  <empty> | <open> attrlist <close>
+    // attrlist       ->  <empty> | attrassign moreattrassign
+    // attrassign     ->  <id> <assign> <value>
+    // moreattrassign ->  <empty> | <attrsep> attrassign    
+    // depexpr        ->  <collsep> <id> <assign> <id>
+    void AssignExpr()
+    {
+        const std::string lvalue = NextLexem();
+        Match( Token::id );
+        switch ( lookahead.type )
+        {
+            case Token::assign:
+            {
+                Match( Token::assign );
+                Match( Token::create );
+                const std::string rvalue = NextLexem();
+                Match( Token::id );
+                if ( lookahead.type == Token::open )
+                {
+                    Match( Token::open );
+                    while ( lookahead.type == Token::id )
+                    {
+                        const std::string attId = NextLexem();
+                        Match( Token::id );
+                        Match( Token::assign );
+                        const std::string attValue = NextLexem();
+                        Match( Token::value );
+                        actions.AssignAttribute( lvalue, attId, attValue );
+                        if ( lookahead.type == Token::attrsep ) Match( Token::attrsep );
+                    }
+                    Match( Token::close );
+                }
+                actions.Create( lvalue, rvalue );
+                break;
+            }
+            case Token::collsep:
+            {
+                Match( Token::collsep );
+                const std::string dep = NextLexem();
+                Match( Token::id );
+                Match( Token::assign );
+                const std::string rvalue = NextLexem();
+                Match( Token::id );
+                actions.AssignDep( lvalue, dep, rvalue );
+                break;
+            }
+            default:
+                throw SyntaxError( "expecting = or .", input.Line(), input.Col() ); // TODO
+        }
+    }
+#endif
+    void Match( Token::Type t )
+    {
+        if ( lookahead.type == t ) lookahead = input.Next();
+        else throw SyntaxError( "expecting token " + Token::Description( t ) + ". Got " + Token::Description(lookahead.type), input.Line(), input.Col() ); // TODO error msg (e.g., "expecting t")
+    }
+    void Match( Keyword k )
+    {
+        if ( lookahead.type == Token::keyword && lookahead.keywordValue == k ) lookahead = input.Next();
+        else throw SyntaxError( "expecting " + std::string(Name(k)) + ", got " + std::string(lookahead.lexem), input.Line(), input.Col() );
+    }
+    // the view is valid until the next Match
+    std::string_view NextLexem() const
+    {
+        return lookahead.lexem;
+    }
+    // the int literals are 32 bit words
+    std::int32_t IntValue(std::string_view literal) const
+    {
+        std::uint32_t value = 0;
+        const auto result = std::from_chars(literal.data(), literal.data() + literal.size(), value);
+        if (result.ec == std::errc::result_out_of_range)
+            throw SyntaxError( "Integer literal too large: " + std::string(literal), input.Line(), input.Col() );
+        if (result.ptr != literal.data() + literal.size())
+            throw SyntaxError( "Invalid integer literal: " + std::string(literal), input.Line(), input.Col() );
+        return static_cast<std::int32_t>(value);
+    }
+    // an operator or a parenthesis waiting for its operands
+    struct Pending
+    {
+        enum Kind { unary, binary, parenthesis } kind;
+        AST::UnaryOperator unaryOp;
+        AST::BinaryOperator binaryOp;
+
+        static Pending Unary(AST::UnaryOperator op) { return { unary, op, AST::BinaryOperator() }; }
+        static Pending Binary(AST::BinaryOperator op) { return { binary, AST::UnaryOperator(), op }; }
+        static Pending Parenthesis() { return { parenthesis, AST::UnaryOperator(), AST::BinaryOperator() }; }
+    };
+    static bool IsBinaryOperator(std::string_view lexem, AST::BinaryOperator& op)
+    {
+        if (lexem.size() != 1)
+            return false;
+        switch (lexem[0])
+        {
+            case '+': op = AST::BinaryOperator::addition; return true;
+            case '-': op = AST::BinaryOperator::subtraction; return true;
+            case '*': op = AST::BinaryOperator::multiplication; return true;
+            case '/': op = AST::BinaryOperator::division; return true;
+            default: return false;
+        }
+    }
+    static int Precedence(AST::BinaryOperator op)
+    {
+        return (op == AST::BinaryOperator::addition || op == AST::BinaryOperator::subtraction) ? 1 : 2;
+    }
+    Source input;
+    Token lookahead;
+    Arena& arena;
+};
+
+#endif // PARSER_H_
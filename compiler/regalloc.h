@@ -0,0 +1,437 @@
+// Register allocating backend of dcc.
+//
+// Unlike AST::Node::Emit, that keeps every intermediate value on the stack,
+// RegisterEmitter keeps them in the general purpose registers, choosing the
+// evaluation order of the operands with the Sethi-Ullman numbering, so that
+// it spills a value on the stack only when the registers are over.
+
+#ifndef REGALLOC_H_
+#define REGALLOC_H_
+
+#include <algorithm>
+#include <ostream>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+#include "ast.h"
+#include "strength.h"
+
+class RegisterEmitter : private AST::StepVisitor
+{
+public:
+    explicit RegisterEmitter(std::ostream& _out) : out(&_out) {}
+
+    void Emit(const AST::Node& root)
+    {
+        Labeler(labels).Label(root);
+        childRegisters = Registers();
+        Walk(root);
+    }
+
+private:
+    // edx is not allocated, because idivl uses it as the high word of the dividend
+    enum Register { eax, ecx, ebx, esi, edi, register_count };
+
+    static const char* Name(Register r)
+    {
+        static const char* const names[] = { "%eax", "%ecx", "%ebx", "%esi", "%edi" };
+        return names[r];
+    }
+    static bool HasLowByte(Register r) { return r == eax || r == ecx || r == ebx; }
+    static const char* LowByte(Register r)
+    {
+        static const char* const names[] = { "%al", "%cl", "%bl" };
+        return names[r];
+    }
+    static bool CalleeSaved(Register r) { return r == ebx || r == esi || r == edi; }
+
+    // The registers available to evaluate a subtree (in order of preference).
+    // The ones not in the set hold values still needed.
+    class Registers
+    {
+    public:
+        Registers() : count(register_count)
+        {
+            for (int i = 0; i < register_count; ++i)
+                regs[i] = static_cast<Register>(i);
+        }
+        std::size_t Size() const { return count; }
+        Register First() const { return regs[0]; }
+        bool Contains(Register r) const { return std::find(regs, regs + count, r) != regs + count; }
+        Registers Without(Register r) const
+        {
+            Registers result(*this);
+            result.count = std::remove(result.regs, result.regs + count, r) - result.regs;
+            return result;
+        }
+    private:
+        Register regs[register_count];
+        std::size_t count;
+    };
+
+    // Returns the operand that is a literal to encode in the instruction
+    // (the right one, or either one if the operation is commutative),
+    // nullptr if there isn't any.
+    // The division by a literal is not encoded as an immediate because it needs
+    // a scratch register, so it's not considered here.
+    static const AST::IntLiteral* Immediate(const AST::BinaryOp& node)
+    {
+        if (node.Operation() == AST::BinaryOperator::division)
+            return nullptr;
+        if (auto right = dynamic_cast<const AST::IntLiteral*>(&node.Right()))
+            return right;
+        if (node.Operation() == AST::BinaryOperator::subtraction)
+            return nullptr;
+        return dynamic_cast<const AST::IntLiteral*>(&node.Left());
+    }
+
+    // the operand that is not the immediate one
+    static const AST::Node& Other(const AST::BinaryOp& node, const AST::IntLiteral* immediate)
+    {
+        return immediate == &node.Right() ? node.Left() : node.Right();
+    }
+
+    // Sethi-Ullman numbering: computes the number of registers needed
+    // to evaluate each subtree without spilling
+    class Labeler : private AST::StepVisitor
+    {
+    public:
+        explicit Labeler(std::unordered_map<const AST::Node*, int>& _labels) : labels(_labels) {}
+        void Label(const AST::Node& root) { Walk(root); }
+    private:
+        // the children are labeled before the last step of a node
+        void Visit(const AST::IntLiteral& node) override { labels[&node] = 1; }
+        void Visit(const AST::Return& node) override { Unary(node, node.Expression()); }
+        void Visit(const AST::UnaryOperation& node) override { Unary(node, node.Operand()); }
+        void Visit(const AST::BinaryOp& node) override
+        {
+            if (auto immediate = Immediate(node))
+            {
+                Unary(node, Other(node, immediate));
+                return;
+            }
+            switch (Stage())
+            {
+                case 0: Then(node.Left()); return;
+                case 1: Then(node.Right()); return;
+            }
+            const int l = labels[&node.Left()];
+            const int r = labels[&node.Right()];
+            labels[&node] = (l == r) ? l + 1 : std::max(l, r);
+        }
+        void Visit(const AST::Function& node) override { Unary(node, node.Body()); }
+        // the label of node is the one of its only child
+        void Unary(const AST::Node& node, const AST::Node& child)
+        {
+            if (Stage() == 0)
+                Then(child);
+            else
+                labels[&node] = labels[&child];
+        }
+
+        std::unordered_map<const AST::Node*, int>& labels;
+    };
+
+    // The tree is walked with the registers available to evaluate a node
+    // on top of frames, with the registers holding the results of its
+    // children as they get known.
+    struct Frame
+    {
+        Registers available;
+        Register l = eax, r = eax;
+        int order = 0; // of the operands, see Visit(BinaryOp)
+    };
+
+    // walk child next, with the registers in available
+    void Generate(const AST::Node& child, const Registers& available)
+    {
+        childRegisters = available;
+        Then(child);
+    }
+    // at the first step of a node
+    Frame& Enter()
+    {
+        if (Stage() == 0)
+            frames.push_back(Frame{ childRegisters });
+        return frames.back();
+    }
+    // the node is done, with the result in r
+    void Leave(Register r)
+    {
+        frames.pop_back();
+        result = r;
+    }
+
+    void Use(Register r)
+    {
+        if (CalleeSaved(r))
+            used[r] = true;
+    }
+
+    void Visit(const AST::IntLiteral& node) override
+    {
+        const Register r = Enter().available.First();
+        Use(r);
+        *out << "movl $" << node.Value() << ", " << Name(r) << "\n";
+        Leave(r);
+    }
+
+    void Visit(const AST::UnaryOperation& node) override
+    {
+        Frame& frame = Enter();
+        if (Stage() == 0)
+        {
+            Generate(node.Operand(), frame.available);
+            return;
+        }
+        const Register r = result;
+        switch (node.Operation())
+        {
+            case AST::UnaryOperator::negation:
+                *out << "neg " << Name(r) << "\n";
+                break;
+            case AST::UnaryOperator::bitwise_complement:
+                *out << "not " << Name(r) << "\n";
+                break;
+            case AST::UnaryOperator::logical_negation:
+                if (HasLowByte(r))
+                {
+                    *out << "cmpl $0, " << Name(r) << "\n";
+                    *out << "movl $0, " << Name(r) << "\n";
+                    *out << "sete " << LowByte(r) << "\n";
+                }
+                else
+                {
+                    *out << "neg " << Name(r) << "\n"; // CF = (r != 0)
+                    *out << "sbbl " << Name(r) << ", " << Name(r) << "\n"; // r = -CF
+                    *out << "incl " << Name(r) << "\n"; // r = 1 - CF
+                }
+                break;
+        }
+        Leave(r);
+    }
+
+    void Visit(const AST::BinaryOp& node) override
+    {
+        Frame& frame = Enter();
+        const Registers& all = frame.available;
+        if (auto immediate = Immediate(node))
+        {
+            if (Stage() == 0)
+            {
+                Generate(Other(node, immediate), all);
+                return;
+            }
+            const Register l = result;
+            if (node.Operation() == AST::BinaryOperator::multiplication)
+                StrengthReduction::Multiply(*out, Name(l), immediate->Value());
+            else
+                *out << Instruction(node.Operation()) << " $" << immediate->Value() << ", " << Name(l) << "\n";
+            Leave(l);
+            return;
+        }
+        auto divisor = dynamic_cast<const AST::IntLiteral*>(&node.Right());
+        if (node.Operation() == AST::BinaryOperator::division && divisor != nullptr && divisor->Value() != 0)
+        {
+            // the label of the literal is 1, so there is a register for it:
+            // DivideByConstant uses it as scratch
+            if (Stage() == 0)
+            {
+                Generate(node.Left(), all);
+                return;
+            }
+            const Register l = result;
+            DivideByConstant(l, divisor->Value(), all);
+            Leave(l);
+            return;
+        }
+
+        enum { leftFirst, rightFirst, spill };
+        switch (Stage())
+        {
+            case 0:
+            {
+                const int leftLabel = labels[&node.Left()];
+                const int rightLabel = labels[&node.Right()];
+                const int k = static_cast<int>(all.Size());
+                if (leftLabel >= rightLabel && rightLabel < k)
+                {
+                    frame.order = leftFirst;
+                    Generate(node.Left(), all);
+                }
+                else if (rightLabel > leftLabel && leftLabel < k)
+                {
+                    frame.order = rightFirst;
+                    Generate(node.Right(), all);
+                }
+                else // both need all the registers: spill the right one
+                {
+                    frame.order = spill;
+                    Generate(node.Right(), all);
+                }
+                return;
+            }
+            case 1:
+                switch (frame.order)
+                {
+                    case leftFirst:
+                        frame.l = result;
+                        Generate(node.Right(), all.Without(frame.l));
+                        break;
+                    case rightFirst:
+                        frame.r = result;
+                        Generate(node.Left(), all.Without(frame.r));
+                        break;
+                    case spill:
+                        *out << "push " << Name(result) << "\n";
+                        Generate(node.Left(), all);
+                        break;
+                }
+                return;
+        }
+        switch (frame.order)
+        {
+            case leftFirst:
+                frame.r = result;
+                break;
+            case rightFirst:
+                frame.l = result;
+                break;
+            case spill:
+                frame.l = result;
+                frame.r = all.Without(frame.l).First();
+                Use(frame.r);
+                *out << "pop " << Name(frame.r) << "\n";
+                break;
+        }
+
+        if (node.Operation() == AST::BinaryOperator::division)
+            Divide(frame.l, frame.r, all);
+        else
+            *out << Instruction(node.Operation()) << " " << Name(frame.r) << ", " << Name(frame.l) << "\n";
+        Leave(frame.l);
+    }
+
+    // l = l / r.
+    // idivl wants the dividend in edx:eax, and leaves the quotient in eax.
+    void Divide(Register l, Register r, const Registers& all)
+    {
+        if (l == eax)
+        {
+            *out << "cltd\n";
+            *out << "idivl " << Name(r) << "\n";
+        }
+        else if (r == eax) // the divisor is not needed after the division
+        {
+            *out << "xchgl %eax, " << Name(l) << "\n";
+            *out << "cltd\n";
+            *out << "idivl " << Name(l) << "\n";
+            *out << "movl %eax, " << Name(l) << "\n";
+        }
+        else if (all.Contains(eax)) // eax is free
+        {
+            *out << "movl " << Name(l) << ", %eax\n";
+            *out << "cltd\n";
+            *out << "idivl " << Name(r) << "\n";
+            *out << "movl %eax, " << Name(l) << "\n";
+        }
+        else // eax holds a value still needed: swap it with the dividend
+        {
+            *out << "xchgl %eax, " << Name(l) << "\n";
+            *out << "cltd\n";
+            *out << "idivl " << Name(r) << "\n";
+            *out << "xchgl %eax, " << Name(l) << "\n";
+        }
+    }
+
+    // l = l / d, with d != 0
+    void DivideByConstant(Register l, std::int32_t d, const Registers& all)
+    {
+        if (StrengthReduction::DivideByPowerOfTwo(*out, Name(l), "%edx", d))
+            return;
+        if (l == eax)
+        {
+            const Register scratch = all.Without(eax).First();
+            Use(scratch);
+            *out << "movl %eax, " << Name(scratch) << "\n";
+            StrengthReduction::DivideByMagic(*out, Name(scratch), d);
+        }
+        else if (all.Contains(eax)) // eax is free
+        {
+            StrengthReduction::DivideByMagic(*out, Name(l), d);
+            *out << "movl %eax, " << Name(l) << "\n";
+        }
+        else // eax holds a value still needed
+        {
+            *out << "push %eax\n";
+            StrengthReduction::DivideByMagic(*out, Name(l), d);
+            *out << "movl %eax, " << Name(l) << "\n";
+            *out << "pop %eax\n";
+        }
+    }
+
+    static const char* Instruction(AST::BinaryOperator op)
+    {
+        switch (op)
+        {
+            case AST::BinaryOperator::addition: return "addl";
+            case AST::BinaryOperator::subtraction: return "subl";
+            case AST::BinaryOperator::multiplication: return "imull";
+            case AST::BinaryOperator::division: return "idivl";
+        }
+        return "???"; // can't reach this point
+    }
+
+    void Visit(const AST::Return& node) override
+    {
+        Enter();
+        if (Stage() == 0)
+        {
+            Generate(node.Expression(), Registers());
+            return;
+        }
+        const Register r = result;
+        if (r != eax)
+            *out << "movl " << Name(r) << ", %eax\n";
+        for (int i = register_count - 1; i >= 0; --i)
+            if (used[i])
+                *out << "pop " << Name(static_cast<Register>(i)) << "\n";
+        *out << "ret\n";
+        Leave(r);
+    }
+
+    // the callee saved registers used are known only after the body
+    // has been generated, so the body goes in a buffer
+    // to emit the prologue before it
+    void Visit(const AST::Function& node) override
+    {
+        Frame& frame = Enter();
+        if (Stage() == 0)
+        {
+            target = out;
+            out = &body;
+            Generate(node.Body(), frame.available);
+            return;
+        }
+        out = target;
+
+        *out << ".globl " << node.Name() << "\n"
+             << node.Name() << ":\n";
+        for (int i = 0; i < register_count; ++i)
+            if (used[i])
+                *out << "push " << Name(static_cast<Register>(i)) << "\n";
+        *out << body.str();
+        Leave(result);
+    }
+
+    std::ostream* out;
+    std::ostream* target = nullptr; // out, while the function body goes in body
+    std::ostringstream body;
+    std::unordered_map<const AST::Node*, int> labels;
+    bool used[register_count] = {};
+    std::vector<Frame> frames;
+    Registers childRegisters; // for the next node walked
+    Register result = eax; // of the last node done
+};
+
+#endif // REGALLOC_H_
@@ -0,0 +1,56 @@
+#!/bin/bash
+
+# Generate samples that multiply and divide by constants, compile them
+# with every backend (and directly to an object file) and check that the exit codes of the executables
+# match the values computed by the dcc interpreter.
+# The samples are compiled with --no-fold: the constant expressions
+# would be folded away before reaching the backends, otherwise.
+
+export LD_LIBRARY_PATH=/home/daniele/libs/boost_1_66_0/install/x86/lib
+DCC=../dcc
+WORKDIR=$(mktemp -d)
+trap "rm -rf $WORKDIR" EXIT
+
+count=0
+failures=0
+
+check()
+{
+    local expr="$1"
+    local src=$WORKDIR/sample.c
+    printf 'int main()\n{\n    return %s;\n}\n' "$expr" > $src
+    local expected=$($DCC --interpret $src)
+    expected=$(( expected & 255 )) # only the low byte gets to the exit code
+    for backend in stack registers ir object
+    do
+        if [ $backend = object ]
+        then
+            $DCC --no-fold --object $src > /dev/null
+            gcc -m32 $WORKDIR/sample.o -o $WORKDIR/sample
+        else
+            $DCC --no-fold --backend=$backend $src > /dev/null
+            gcc -m32 $WORKDIR/sample.s -o $WORKDIR/sample
+        fi
+        $WORKDIR/sample
+        local actual=$?
+        count=$(( count + 1 ))
+        if [ $actual -ne $expected ]
+        then
+            echo "FAILED ($backend): $expr returned $actual, expected $expected"
+            failures=$(( failures + 1 ))
+        fi
+    done
+}
+
+for c in 0 1 2 3 5 6 7 9 10 12 16 24 25 36 100 641 1000 65536 1073741824 2147483647
+do
+    for x in 0 1 7 -7 255 -256 123456789 -2147483647
+    do
+        check "($x) * $c"
+        check "$c * ($x)"
+        [ $c -ne 0 ] && check "($x) / $c"
+    done
+done
+
+echo "$count checks, $failures failures"
+[ $failures -eq 0 ]
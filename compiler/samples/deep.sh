@@ -0,0 +1,73 @@
+#!/bin/bash
+
+# Compile expressions nested 200000 levels deep with every backend, with a
+# native stack of 1 MB, and check that the exit codes of the executables
+# match the values computed by the dcc interpreter.
+# No pass of dcc recurses on the tree, so the depth needs no stack.
+# The executables are linked with a _start of their own, without the C library.
+
+export LD_LIBRARY_PATH=/home/daniele/libs/boost_1_66_0/install/x86/lib
+DCC=../dcc
+DEPTH=200000
+WORKDIR=$(mktemp -d)
+trap "rm -rf $WORKDIR" EXIT
+
+printf '.globl _start\n_start:\ncall main\nmovl %%eax, %%ebx\nmovl $1, %%eax\nint $0x80\n' > $WORKDIR/start.s
+
+count=0
+failures=0
+
+# n copies of text
+repeat()
+{
+    yes -- "$2" | head -n $1 | tr -d '\n'
+}
+
+check()
+{
+    local name="$1"
+    local expr="$2"
+    local src=$WORKDIR/$name.c
+    printf 'int main()\n{\n    return %s;\n}\n' "$expr" > $src
+    local expected=$( ulimit -s 1024; $DCC --interpret $src )
+    if [ $? -ne 0 ]
+    then
+        echo "FAILED (interpreter): $name"
+        failures=$(( failures + 1 ))
+        return
+    fi
+    expected=$(( expected & 255 )) # only the low byte gets to the exit code
+    for options in "" "--no-fold" "--backend=registers" "--no-fold --backend=registers" \
+                   "--backend=ir" "--no-fold --backend=ir" "--object" "--no-fold --object"
+    do
+        count=$(( count + 1 ))
+        local output=$WORKDIR/$name.s
+        [[ $options == *--object* ]] && output=$WORKDIR/$name.o
+        rm -f $output
+        if ! ( ulimit -s 1024; $DCC $options $src > /dev/null )
+        then
+            echo "FAILED ($name $options): dcc exited with $?"
+            failures=$(( failures + 1 ))
+            continue
+        fi
+        gcc -m32 -nostdlib -static $WORKDIR/start.s $output -o $WORKDIR/$name 2> /dev/null
+        $WORKDIR/$name
+        local actual=$?
+        if [ $actual -ne $expected ]
+        then
+            echo "FAILED ($name $options): returned $actual, expected $expected"
+            failures=$(( failures + 1 ))
+        fi
+    done
+}
+
+check negations "$(repeat $DEPTH -)1"
+check complements "$(repeat $DEPTH '~')7"
+check sum "1$(repeat $DEPTH +1)"
+check products "3$(repeat $DEPTH '*-1')"
+check parentheses "$(repeat $DEPTH '(')1$(repeat $DEPTH '+1)')"
+check right_nested "$(repeat $DEPTH '2-(')1$(repeat $DEPTH ')')"
+check divisions "$(repeat $DEPTH '(')1000000$(repeat $DEPTH '/1)')"
+
+echo "$count checks, $failures failures"
+[ $failures -eq 0 ]
@@ -0,0 +1,157 @@
+// Strength reduction of multiplications and divisions by constants,
+// shared by the backends.
+// Every function takes the names of the registers to use (e.g., "%eax").
+
+#ifndef STRENGTH_H_
+#define STRENGTH_H_
+
+#include <cstdint>
+#include <ostream>
+
+namespace StrengthReduction
+{
+    namespace detail
+    {
+        // returns the exponent if x is a power of two, -1 otherwise
+        inline int Log2(std::uint32_t x)
+        {
+            if (x == 0 || (x & (x - 1)) != 0)
+                return -1;
+            int result = 0;
+            while (x >>= 1)
+                ++result;
+            return result;
+        }
+
+        inline std::uint32_t Abs(std::int32_t x)
+        {
+            return x < 0 ? 0u - static_cast<std::uint32_t>(x) : static_cast<std::uint32_t>(x);
+        }
+    } // detail
+
+    // x = x * c, with shifts and lea when possible.
+    inline void Multiply(std::ostream& out, const char* x, std::int32_t c)
+    {
+        const std::uint32_t magnitude = detail::Abs(c);
+        if (c == 0)
+        {
+            out << "movl $0, " << x << "\n";
+            return;
+        }
+        const int shift = detail::Log2(magnitude);
+        if (shift >= 0) // +-2^k: the sign of INT_MIN doesn't matter, as x << 31 == -(x << 31)
+        {
+            if (shift > 0)
+                out << "shll $" << shift << ", " << x << "\n";
+            if (c < 0 && shift != 31)
+                out << "neg " << x << "\n";
+            return;
+        }
+        if (c > 0)
+        {
+            for (std::uint32_t m: { 3u, 5u, 9u })
+            {
+                const int k = (magnitude % m == 0) ? detail::Log2(magnitude / m) : -1;
+                if (k >= 0) // c == m * 2^k
+                {
+                    out << "leal (" << x << "," << x << "," << m - 1 << "), " << x << "\n";
+                    if (k > 0)
+                        out << "shll $" << k << ", " << x << "\n";
+                    return;
+                }
+            }
+        }
+        out << "imull $" << c << ", " << x << "\n";
+    }
+
+    // true if d is +-1 or +-2^k (k < 31)
+    inline bool IsPowerOfTwo(std::int32_t d)
+    {
+        const int k = detail::Log2(detail::Abs(d));
+        return k >= 0 && k < 31;
+    }
+
+    // x = x / d if d is +-1 or +-2^k (k < 31), using scratch.
+    // Returns false (emitting nothing) for the other divisors.
+    inline bool DivideByPowerOfTwo(std::ostream& out, const char* x, const char* scratch, std::int32_t d)
+    {
+        if (!IsPowerOfTwo(d))
+            return false;
+        const int k = detail::Log2(detail::Abs(d));
+        if (k > 0)
+        {
+            // a negative dividend must be biased by 2^k-1 to truncate toward zero
+            out << "movl " << x << ", " << scratch << "\n";
+            if (k > 1)
+                out << "sarl $31, " << scratch << "\n";
+            out << "shrl $" << 32 - k << ", " << scratch << "\n";
+            out << "addl " << scratch << ", " << x << "\n";
+            out << "sarl $" << k << ", " << x << "\n";
+        }
+        if (d < 0)
+            out << "neg " << x << "\n";
+        return true;
+    }
+
+    // Magic number and shift to compute n / d as (n * m) >> (32 + s), see
+    // Granlund, Montgomery "Division by invariant integers using multiplication"
+    // and Warren "Hacker's Delight", 10-4.
+    // d must not be 0, 1 or -1.
+    struct Magic
+    {
+        std::int32_t multiplier;
+        int shift;
+    };
+
+    inline Magic SignedMagic(std::int32_t d)
+    {
+        const std::uint32_t two31 = 0x80000000u;
+        const std::uint32_t ad = detail::Abs(d);
+        const std::uint32_t t = two31 + (static_cast<std::uint32_t>(d) >> 31);
+        const std::uint32_t anc = t - 1 - t % ad; // absolute value of nc
+        int p = 31;
+        std::uint32_t q1 = two31 / anc; // q1 = 2^p / |nc|
+        std::uint32_t r1 = two31 - q1 * anc; // r1 = rem(2^p, |nc|)
+        std::uint32_t q2 = two31 / ad; // q2 = 2^p / |d|
+        std::uint32_t r2 = two31 - q2 * ad; // r2 = rem(2^p, |d|)
+        std::uint32_t delta;
+        do
+        {
+            ++p;
+            q1 *= 2;
+            r1 *= 2;
+            if (r1 >= anc) { ++q1; r1 -= anc; }
+            q2 *= 2;
+            r2 *= 2;
+            if (r2 >= ad) { ++q2; r2 -= ad; }
+            delta = ad - r2;
+        }
+        while (q1 < delta || (q1 == delta && r1 == 0));
+
+        std::uint32_t m = q2 + 1;
+        if (d < 0)
+            m = 0u - m;
+        return { static_cast<std::int32_t>(m), p - 32 };
+    }
+
+    // eax = n / d with a multiplication by the magic number.
+    // n must be a register other than eax and edx, and it's preserved.
+    // Clobbers edx.
+    inline void DivideByMagic(std::ostream& out, const char* n, std::int32_t d)
+    {
+        const Magic magic = SignedMagic(d);
+        out << "movl $" << magic.multiplier << ", %eax\n";
+        out << "imull " << n << "\n"; // edx = high word of n * multiplier
+        if (d > 0 && magic.multiplier < 0)
+            out << "addl " << n << ", %edx\n";
+        else if (d < 0 && magic.multiplier > 0)
+            out << "subl " << n << ", %edx\n";
+        if (magic.shift > 0)
+            out << "sarl $" << magic.shift << ", %edx\n";
+        out << "movl %edx, %eax\n";
+        out << "shrl $31, %eax\n"; // add 1 if the quotient is negative
+        out << "addl %edx, %eax\n";
+    }
+} // StrengthReduction
+
+#endif // STRENGTH_H_
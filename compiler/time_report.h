@@ -0,0 +1,160 @@
+// Time and memory report of the phases of a compilation (--time-report):
+// wall time, CPU time of the thread and heap allocations of each phase.
+// The allocations are counted by the global operator new of main.cpp,
+// for each thread, so that files compiled in parallel don't mix.
+
+#ifndef TIME_REPORT_H_
+#define TIME_REPORT_H_
+
+#include <cstddef>
+#include <iomanip>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+#include <boost/chrono.hpp>
+#include <boost/chrono/thread_clock.hpp>
+
+namespace AllocationCounter
+{
+    inline thread_local std::size_t count = 0;
+    inline thread_local std::size_t bytes = 0;
+
+    inline void Add(std::size_t size)
+    {
+        ++count;
+        bytes += size;
+    }
+} // AllocationCounter
+
+class TimeReport
+{
+public:
+    struct Phase
+    {
+        std::string name;
+        double wallMs = 0;
+        double cpuMs = 0;
+        std::size_t allocations = 0;
+        std::size_t bytes = 0;
+    };
+
+    // Measures the phase from the construction to the destruction.
+    // Does nothing if report is null.
+    class Scope
+    {
+    public:
+        Scope(TimeReport* _report, const char* _name) :
+            report(_report), name(_name),
+            allocations(AllocationCounter::count), bytes(AllocationCounter::bytes),
+            wallStart(boost::chrono::steady_clock::now()),
+            cpuStart(boost::chrono::thread_clock::now())
+        {}
+        Scope(const Scope&) = delete;
+        Scope& operator = (const Scope&) = delete;
+        ~Scope()
+        {
+            if (report == nullptr)
+                return;
+            using Ms = boost::chrono::duration<double, boost::milli>;
+            Phase phase;
+            phase.name = name;
+            phase.cpuMs = Ms(boost::chrono::thread_clock::now() - cpuStart).count();
+            phase.wallMs = Ms(boost::chrono::steady_clock::now() - wallStart).count();
+            phase.allocations = AllocationCounter::count - allocations;
+            phase.bytes = AllocationCounter::bytes - bytes;
+            report->phases.push_back(phase);
+        }
+    private:
+        TimeReport* report;
+        const char* name;
+        const std::size_t allocations;
+        const std::size_t bytes;
+        const boost::chrono::steady_clock::time_point wallStart;
+        const boost::chrono::thread_clock::time_point cpuStart;
+    };
+
+    explicit TimeReport(std::string _file = std::string()) : file(std::move(_file)) {}
+
+    const std::vector<Phase>& Phases() const { return phases; }
+
+    Phase Total() const
+    {
+        Phase total;
+        total.name = "total";
+        for (const auto& p: phases)
+        {
+            total.wallMs += p.wallMs;
+            total.cpuMs += p.cpuMs;
+            total.allocations += p.allocations;
+            total.bytes += p.bytes;
+        }
+        return total;
+    }
+
+    // a table, like gcc -ftime-report
+    void Print(std::ostream& out) const
+    {
+        out << "Time report for " << file << ":\n";
+        out << std::left << std::setw(26) << "phase" << std::right
+            << std::setw(12) << "wall ms" << std::setw(12) << "cpu ms"
+            << std::setw(14) << "allocations" << std::setw(14) << "bytes" << "\n";
+        const auto row = [&](const Phase& p)
+        {
+            out << std::left << std::setw(26) << p.name << std::right << std::fixed << std::setprecision(3)
+                << std::setw(12) << p.wallMs << std::setw(12) << p.cpuMs
+                << std::setw(14) << p.allocations << std::setw(14) << p.bytes << "\n";
+        };
+        for (const auto& p: phases)
+            row(p);
+        row(Total());
+        out.unsetf(std::ios::floatfield);
+    }
+
+    // one JSON object: {"file": ..., "phases": [...], "total": {...}}
+    void PrintJson(std::ostream& out) const
+    {
+        const auto phase = [&](const Phase& p)
+        {
+            out << "{\"name\": " << Quote(p.name) << std::fixed << std::setprecision(6)
+                << ", \"wall_ms\": " << p.wallMs << ", \"cpu_ms\": " << p.cpuMs
+                << ", \"allocations\": " << p.allocations << ", \"bytes\": " << p.bytes << "}";
+            out.unsetf(std::ios::floatfield);
+        };
+        out << "{\"file\": " << Quote(file) << ", \"phases\": [";
+        for (std::size_t i = 0; i < phases.size(); ++i)
+        {
+            out << (i == 0 ? "" : ", ");
+            phase(phases[i]);
+        }
+        out << "], \"total\": ";
+        phase(Total());
+        out << "}";
+    }
+
+private:
+    static std::string Quote(const std::string& s)
+    {
+        std::string result = "\"";
+        for (char c: s)
+        {
+            if (c == '"' || c == '\\')
+                result += '\\';
+            if (static_cast<unsigned char>(c) < 0x20)
+            {
+                static const char hex[] = "0123456789abcdef";
+                result += "\\u00";
+                result += hex[c >> 4];
+                result += hex[c & 0xF];
+            }
+            else
+                result += c;
+        }
+        return result + "\"";
+    }
+
+    std::string file;
+    std::vector<Phase> phases;
+};
+
+#endif // TIME_REPORT_H_
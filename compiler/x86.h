@@ -0,0 +1,295 @@
+// Machine code generation for x86 (32 bit), without going through the
+// assembler: the instructions are encoded directly in memory.
+// The code is the same generated by the stack emitter in ast.h, including
+// the strength reduction of strength.h, so the two outputs are equivalent.
+
+#ifndef X86_H_
+#define X86_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "ast.h"
+#include "strength.h"
+
+namespace X86
+{
+    // the numbers are the ones used in the encoding of the instructions
+    enum Register : std::uint8_t { eax, ecx, edx, ebx, esp, ebp, esi, edi };
+
+    // Encodes the instructions in a buffer, with the AT&T operand order
+    // (source first) to read like the text emitters.
+    // Only the register to register forms used by the code generator are there.
+    class Assembler
+    {
+    public:
+        const std::vector<std::uint8_t>& Code() const { return code; }
+        std::vector<std::uint8_t> Release() { return std::move(code); }
+
+        void Movl(std::int32_t value, Register dest) { Byte(0xB8 + dest); Dword(value); }
+        void Movl(Register src, Register dest) { Byte(0x89); RegReg(src, dest); }
+        void Push(Register r) { Byte(0x50 + r); }
+        void Pop(Register r) { Byte(0x58 + r); }
+        void Neg(Register r) { Byte(0xF7); Extension(3, r); }
+        void Not(Register r) { Byte(0xF7); Extension(2, r); }
+        void Cmpl(std::int8_t value, Register r) { Byte(0x83); Extension(7, r); Byte(value); }
+        void SeteAl() { Byte(0x0F); Byte(0x94); Byte(0xC0); }
+        void Addl(Register src, Register dest) { Byte(0x01); RegReg(src, dest); }
+        void Subl(Register src, Register dest) { Byte(0x29); RegReg(src, dest); }
+        void Imull(Register src, Register dest) { Byte(0x0F); Byte(0xAF); RegReg(dest, src); }
+        void Imull(std::int32_t value, Register r)
+        {
+            if (value >= -128 && value <= 127)
+            {
+                Byte(0x6B); RegReg(r, r); Byte(value);
+            }
+            else
+            {
+                Byte(0x69); RegReg(r, r); Dword(value);
+            }
+        }
+        void Imull(Register r) { Byte(0xF7); Extension(5, r); } // edx:eax = eax * r
+        void Idivl(Register r) { Byte(0xF7); Extension(7, r); } // eax = edx:eax / r
+        void Cltd() { Byte(0x99); }
+        void Shll(int count, Register r) { Shift(4, count, r); }
+        void Shrl(int count, Register r) { Shift(5, count, r); }
+        void Sarl(int count, Register r) { Shift(7, count, r); }
+        // dest = base + index * scale, scale is 1, 2, 4 or 8
+        void Leal(Register base, Register index, int scale, Register dest)
+        {
+            const int ss = scale == 8 ? 3 : scale == 4 ? 2 : scale == 2 ? 1 : 0;
+            Byte(0x8D);
+            if (base == ebp) // ebp as base is only allowed with a displacement
+            {
+                Byte(0x44 | dest << 3);
+                Byte(ss << 6 | index << 3 | base);
+                Byte(0);
+            }
+            else
+            {
+                Byte(0x04 | dest << 3);
+                Byte(ss << 6 | index << 3 | base);
+            }
+        }
+        void Ret() { Byte(0xC3); }
+
+    private:
+        void Byte(int b) { code.push_back(static_cast<std::uint8_t>(b)); }
+        void Dword(std::int32_t value)
+        {
+            const auto v = static_cast<std::uint32_t>(value);
+            for (int shift = 0; shift < 32; shift += 8)
+                Byte(v >> shift & 0xFF);
+        }
+        void Shift(int opcode, int count, Register r)
+        {
+            if (count == 1) // shorter form, as the assembler does
+            {
+                Byte(0xD1); Extension(opcode, r);
+            }
+            else
+            {
+                Byte(0xC1); Extension(opcode, r); Byte(count);
+            }
+        }
+        // ModRM byte with two registers: reg is the first, r/m the second
+        void RegReg(Register reg, Register rm) { Byte(0xC0 | reg << 3 | rm); }
+        // ModRM byte of the instructions whose reg field is an opcode extension
+        void Extension(int opcode, Register rm) { Byte(0xC0 | opcode << 3 | rm); }
+
+        std::vector<std::uint8_t> code;
+    };
+
+    struct Function
+    {
+        std::string name;
+        std::vector<std::uint8_t> code;
+    };
+
+    // Generates the machine code of the stack emitter, walking the tree
+    // in the same steps as AST::Node::Emit
+    class CodeGenerator : private AST::StepVisitor
+    {
+    public:
+        Function Generate(const AST::Node& root)
+        {
+            Walk(root);
+            return Function{ std::move(name), as.Release() };
+        }
+
+    private:
+        void Visit(const AST::IntLiteral& node) override { as.Movl(node.Value(), eax); }
+
+        void Visit(const AST::Return& node) override
+        {
+            if (Stage() == 0)
+                Then(node.Expression());
+            else
+                as.Ret();
+        }
+
+        void Visit(const AST::Function& node) override
+        {
+            if (Stage() == 0)
+            {
+                name = std::string(node.Name());
+                Then(node.Body());
+            }
+        }
+
+        void Visit(const AST::UnaryOperation& node) override
+        {
+            if (Stage() == 0)
+            {
+                Then(node.Operand());
+                return;
+            }
+            switch (node.Operation())
+            {
+                case AST::UnaryOperator::negation:
+                    as.Neg(eax);
+                    break;
+                case AST::UnaryOperator::bitwise_complement:
+                    as.Not(eax);
+                    break;
+                case AST::UnaryOperator::logical_negation:
+                    as.Cmpl(0, eax);
+                    as.Movl(0, eax); // mov doesn't change the flags
+                    as.SeteAl();
+                    break;
+            }
+        }
+
+        void Visit(const AST::BinaryOp& node) override
+        {
+            auto left = dynamic_cast<const AST::IntLiteral*>(&node.Left());
+            auto right = dynamic_cast<const AST::IntLiteral*>(&node.Right());
+            if (node.Operation() == AST::BinaryOperator::multiplication && (right != nullptr || left != nullptr)) // by a constant
+            {
+                if (Stage() == 0)
+                    Then(right != nullptr ? node.Left() : node.Right());
+                else
+                    Multiply(eax, (right != nullptr ? right : left)->Value());
+                return;
+            }
+            if (node.Operation() == AST::BinaryOperator::division && right != nullptr && right->Value() != 0) // by a constant
+            {
+                if (Stage() == 0)
+                    Then(node.Left());
+                else if (StrengthReduction::IsPowerOfTwo(right->Value()))
+                    DivideByPowerOfTwo(eax, edx, right->Value());
+                else
+                {
+                    as.Movl(eax, ecx);
+                    DivideByMagic(ecx, right->Value());
+                }
+                return;
+            }
+            // ecx = first, eax = second
+            const bool rightFirst = node.Operation() == AST::BinaryOperator::division ||
+                                    node.Operation() == AST::BinaryOperator::subtraction;
+            switch (Stage())
+            {
+                case 0:
+                    Then(rightFirst ? node.Right() : node.Left());
+                    return;
+                case 1:
+                    as.Push(eax);
+                    Then(rightFirst ? node.Left() : node.Right());
+                    return;
+            }
+            as.Pop(ecx);
+            switch (node.Operation())
+            {
+                case AST::BinaryOperator::multiplication:
+                    as.Imull(ecx, eax);
+                    break;
+                case AST::BinaryOperator::division:
+                    as.Cltd();
+                    as.Idivl(ecx);
+                    break;
+                case AST::BinaryOperator::addition:
+                    as.Addl(ecx, eax);
+                    break;
+                case AST::BinaryOperator::subtraction:
+                    as.Subl(ecx, eax);
+                    break;
+            }
+        }
+
+        // The following are the encoded versions of the ones in strength.h
+
+        void Multiply(Register x, std::int32_t c)
+        {
+            using namespace StrengthReduction::detail;
+            const std::uint32_t magnitude = Abs(c);
+            if (c == 0)
+            {
+                as.Movl(0, x);
+                return;
+            }
+            const int shift = Log2(magnitude);
+            if (shift >= 0)
+            {
+                if (shift > 0)
+                    as.Shll(shift, x);
+                if (c < 0 && shift != 31)
+                    as.Neg(x);
+                return;
+            }
+            if (c > 0)
+            {
+                for (std::uint32_t m: { 3u, 5u, 9u })
+                {
+                    const int k = (magnitude % m == 0) ? Log2(magnitude / m) : -1;
+                    if (k >= 0)
+                    {
+                        as.Leal(x, x, m - 1, x);
+                        if (k > 0)
+                            as.Shll(k, x);
+                        return;
+                    }
+                }
+            }
+            as.Imull(c, x);
+        }
+
+        void DivideByPowerOfTwo(Register x, Register scratch, std::int32_t d)
+        {
+            using namespace StrengthReduction::detail;
+            const int k = Log2(Abs(d));
+            if (k > 0)
+            {
+                as.Movl(x, scratch);
+                if (k > 1)
+                    as.Sarl(31, scratch);
+                as.Shrl(32 - k, scratch);
+                as.Addl(scratch, x);
+                as.Sarl(k, x);
+            }
+            if (d < 0)
+                as.Neg(x);
+        }
+
+        void DivideByMagic(Register n, std::int32_t d)
+        {
+            const auto magic = StrengthReduction::SignedMagic(d);
+            as.Movl(magic.multiplier, eax);
+            as.Imull(n);
+            if (d > 0 && magic.multiplier < 0)
+                as.Addl(n, edx);
+            else if (d < 0 && magic.multiplier > 0)
+                as.Subl(n, edx);
+            if (magic.shift > 0)
+                as.Sarl(magic.shift, edx);
+            as.Movl(edx, eax);
+            as.Shrl(31, eax);
+            as.Addl(edx, eax);
+        }
+
+        Assembler as;
+        std::string name;
+    };
+} // X86
+
+#endif // X86_H_
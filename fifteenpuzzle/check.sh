@@ -0,0 +1,61 @@
+#!/bin/bash
+
+# Check that fifteen solves the starts that can reach the goal and rejects,
+# with an error and without searching, the ones that can't: the searches
+# would never end on them (IDA* raises its bound forever).
+
+export LD_LIBRARY_PATH=/home/daniele/libs/boost_1_66_0/install/x86/lib
+FIFTEEN=./fifteen
+WORKDIR=$(mktemp -d)
+trap "rm -rf $WORKDIR" EXIT
+
+count=0
+failures=0
+
+# check expected tiles...: expected is solvable or unsolvable
+check()
+{
+    local expected=$1
+    shift
+    for search in ida bfs
+    do
+        count=$(( count + 1 ))
+        timeout 60 $FIFTEEN --search=$search "$@" > $WORKDIR/out 2>&1
+        local status=$?
+        if [ $expected = solvable ] && ! grep -q "Solution found" $WORKDIR/out
+        then
+            echo "FAILED ($search): $* not solved (exit code $status)"
+            failures=$(( failures + 1 ))
+        elif [ $expected = unsolvable ] && ( [ $status -ne 1 ] || ! grep -q "can't reach the goal" $WORKDIR/out )
+        then
+            echo "FAILED ($search): $* not rejected (exit code $status)"
+            failures=$(( failures + 1 ))
+        fi
+    done
+}
+
+check solvable 1 2 3 4 5 6 7 8 0
+check solvable 1 2 3 4 5 6 0 7 8
+check solvable 8 6 7 2 5 4 3 0 1
+check unsolvable 2 1 3 4 5 6 7 8 0
+check unsolvable 6 8 7 2 5 4 3 0 1
+check solvable 1 2 3 4 5 6 7 8 9 10 11 12 13 14 0 15
+check solvable 1 2 3 4 5 6 7 8 9 10 11 0 13 14 15 12
+check unsolvable 2 1 3 4 5 6 7 8 9 10 11 12 13 14 15 0
+check unsolvable 1 2 3 4 5 6 7 8 9 10 11 12 13 15 14 0
+check unsolvable 1 2 3 4 5 6 7 8 9 10 11 0 13 14 12 15
+check solvable 1 2 3 4 5 6 7 8 9 10 11 12 13 14 15 16 17 18 19 20 21 22 23 0 24
+check unsolvable 1 2 3 4 5 6 7 8 9 10 11 12 13 14 15 16 17 18 19 20 21 22 24 23 0
+
+# the batch mode rejects the file, whatever line can't reach the goal
+count=$(( count + 1 ))
+printf '1 2 3 4 5 6 7 0 8\n2 1 3 4 5 6 7 8 0\n' > $WORKDIR/instances.txt
+if timeout 60 $FIFTEEN --batch=$WORKDIR/instances.txt > $WORKDIR/out 2>&1 ||
+   ! grep -q "instances.txt:2: the instance can't reach the goal" $WORKDIR/out
+then
+    echo "FAILED (batch): the instance of line 2 not rejected"
+    failures=$(( failures + 1 ))
+fi
+
+echo "$count checks, $failures failures"
+[ $failures -eq 0 ]
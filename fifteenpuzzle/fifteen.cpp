@@ -1,16 +1,163 @@
 // fifteen puzzle
 
 #include <iostream>
-#include <queue>
+#include <deque>
 #include <vector>
 #include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <type_traits>
 
+// #define DUMP
+// #define CLOSED_USE_VECTOR   // 2800 ms VS 46 ms !!!!!
+
+// The searches take any State with operator ==, and with
+//     static constexpr int maxNext;
+//     int Next(State (&next)[State::maxNext], const State* parent) const;
+// writing the states one move away in next (but parent, if not null) and
+// returning how many they are: expanding a state allocates nothing.
+
+// State::perfectHashSize if the states have a perfect hash PerfectHash() in
+// [0, perfectHashSize) (the states reachable from one another), else 0
+template <class State, class = void>
+struct PerfectHashSize : std::integral_constant<std::size_t, 0> {};
+
+template <class State>
+struct PerfectHashSize<State, std::void_t<decltype(State::perfectHashSize)>>
+    : std::integral_constant<std::size_t, State::perfectHashSize> {};
+
+// The states visited by a breadth first search.
+// They are kept in a deque, in the order they are found, and the reference
+// to the state they come from (Parent) in another one: the path to a state
+// is rebuilt following the parents back to the start.
+// The hash index of the visited states is an open addressing table of
+// indices in that deque, so a visited state costs one State, one Parent
+// and less than three table slots (the deques grow without copying,
+// so the peak memory is about the same).
+// State needs std::hash<State>.
+// The states with a perfect hash (the small boards) index a table with a
+// slot for every reachable state instead, if perfect: no probing and no
+// rehashing, but the table is allocated whole with the first state.
+
+template <class State, class Parent = std::uint32_t, bool perfect = true>
+class VisitedStates
+{
+public:
+    using Index = std::uint32_t;
+    static constexpr Index none = std::numeric_limits<Index>::max();
+
+    std::size_t Size() const { return states.size(); }
+    const State& operator [] (Index i) const { return states[i]; }
+    Parent ParentOf(Index i) const { return parents[i]; }
+    // the memory growing with the states (not the perfect hash table)
+    std::size_t Memory() const
+    {
+        std::size_t memory = states.size() * sizeof(State) + parents.size() * sizeof(Parent);
 #ifndef CLOSED_USE_VECTOR
-#include <unordered_set>
+        if constexpr (perfectHashSize == 0)
+            memory += table.capacity() * sizeof(Index);
 #endif
+        return memory;
+    }
+    // the perfect hash table, whatever the states
+    std::size_t PreallocatedMemory() const
+    {
+#ifndef CLOSED_USE_VECTOR
+        if constexpr (perfectHashSize != 0)
+            return table.capacity() * sizeof(Index);
+#endif
+        return 0;
+    }
 
-// #define DUMP
-// #define CLOSED_USE_VECTOR   // 2800 ms VS 46 ms !!!!!
+#ifdef CLOSED_USE_VECTOR
+    // the index of s, or none if it's not visited
+    Index Find(const State& s) const
+    {
+        const auto it = std::find(states.begin(), states.end(), s);
+        return it == states.end() ? none : static_cast<Index>(it - states.begin());
+    }
+    // s must not be visited yet
+    Index Add(const State& s, Parent parent)
+    {
+        states.push_back(s);
+        parents.push_back(parent);
+        return static_cast<Index>(states.size() - 1);
+    }
+#else
+    // the index of s, or none if it's not visited
+    Index Find(const State& s) const
+    {
+        if (table.empty())
+            return none;
+        const Index i = table[Slot(s)];
+        if constexpr (perfectHashSize != 0)
+            if (i != 0 && !(states[i - 1] == s)) // not reachable from the states added
+                return none;
+        return i - 1;
+    }
+    // s must not be visited yet
+    Index Add(const State& s, Parent parent)
+    {
+        if (4 * (states.size() + 1) > 3 * table.size()) // load factor at most 3/4
+            Grow();
+        table[Slot(s)] = static_cast<Index>(states.size() + 1);
+        states.push_back(s);
+        parents.push_back(parent);
+        return static_cast<Index>(states.size() - 1);
+    }
+private:
+    // the table slots hold index + 1, 0 is an empty slot
+    std::size_t Slot(const State& s) const
+    {
+        if constexpr (perfectHashSize != 0)
+            return s.PerfectHash();
+        else
+        {
+            const std::size_t mask = table.size() - 1;
+            std::size_t slot = std::hash<State>()(s) & mask;
+            while (table[slot] != 0 && !(states[table[slot] - 1] == s))
+                slot = (slot + 1) & mask;
+            return slot;
+        }
+    }
+    void Grow()
+    {
+        if constexpr (perfectHashSize != 0)
+        {
+            // a slot for every state, only the first time
+            if (table.empty())
+                table.resize(perfectHashSize, 0);
+        }
+        else
+        {
+            const std::size_t size = table.empty() ? 1024 : table.size() * 2;
+            std::vector<Index>().swap(table); // free the old table first
+            table.resize(size, 0);
+            for (std::size_t i = 0; i < states.size(); ++i)
+                table[Slot(states[i])] = static_cast<Index>(i + 1);
+        }
+    }
+
+    static constexpr std::size_t perfectHashSize = perfect ? PerfectHashSize<State>::value : 0;
+    std::vector<Index> table;
+#endif
+private:
+    std::deque<State> states;
+    std::deque<Parent> parents;
+};
+
+// Prints the memory of the searches visiting states: memory grows with them,
+// preallocated is allocated whole at the start.
+void PrintMemory(std::size_t states, std::size_t memory, std::size_t preallocated)
+{
+    std::cout << "Memory: " << (memory + preallocated) / 1024 << " KB, " << memory / states << " bytes per state";
+    if (preallocated != 0)
+        std::cout << " and " << preallocated / 1024 << " KB of perfect hash tables";
+    std::cout << std::endl;
+}
+
+// The states not expanded yet are the tail of the visited states (the queue).
 
 template <class State>
 class BreadthFirst
@@ -18,192 +165,780 @@ class BreadthFirst
 public:
     BreadthFirst(const State& start, const State& _end) : end(_end)
     {
-        open.push(start);        
+        visited.Add(start, Visited::none);
     }
     bool Solve()
     {
-        do
+        for (; next < visited.Size(); ++next)
         {
-            auto current = open.front();
-            open.pop();
-            if ( NextStep(current) )
+            if ( NextStep(next) )
             {
-                solution = current;
+                solution = next;
                 return true;
             }
         }
-        while(!open.empty());
-
         return false;
     }
-    State Solution() const { return solution; }
+    // the states from the start to the end (only the start if not solved)
+    std::vector<State> Path() const
+    {
+        std::vector<State> path;
+        for (Index i = solution; i != Visited::none; i = visited.ParentOf(i))
+            path.push_back(visited[i]);
+        std::reverse(path.begin(), path.end());
+        return path;
+    }
+    unsigned long long Expanded() const { return next; }
+    std::size_t Memory() const { return visited.Memory() + visited.PreallocatedMemory(); }
     void PrintStatistics() const
     {
-        std::cout << "Visited states: " << closed.size() << std::endl;
+        std::cout << "Visited states: " << visited.Size() << std::endl;
+        PrintMemory(visited.Size(), visited.Memory(), visited.PreallocatedMemory());
     }
 private:
-    bool NextStep(const State& current)
+    using Visited = VisitedStates<State>;
+    using Index = typename Visited::Index;
+
+    bool NextStep(Index current)
     {
 #ifdef DUMP        
         std::cout << "\n********* new iteration *************\n" << std::endl;
         std::cout << "current:\n";
-        current.Print();
+        visited[current].Print();
 #endif
 
-        if (current == end)
+        if (visited[current] == end)
             return true; // found
-#ifdef CLOSED_USE_VECTOR
-        closed.push_back(current);
-#else
-        closed.insert(current);
-#endif
-        auto nextStates = current.Next();
+        const Index parent = visited.ParentOf(current);
+        State nextStates[State::maxNext];
+        const int count = visited[current].Next(nextStates, parent == Visited::none ? nullptr : &visited[parent]);
 
 #ifdef DUMP
         std::cout << "\nnext:\n";
 #endif
 
-        for (auto s: nextStates)
+        for (int k = 0; k < count; ++k)
         {
-#ifdef CLOSED_USE_VECTOR
-            if (std::find(closed.begin(), closed.end(), s) == closed.end()) // not visited yet
-#else
-            if ( closed.find(s) == closed.end() ) // not visited yet
-#endif
+            const State& s = nextStates[k];
+            if ( visited.Find(s) == Visited::none )
             {
 #ifdef DUMP
                 s.Print();
 #endif
-                open.push(s);
+                visited.Add(s, current);
             }
         }
         return false;
     }
 
     const State end;
-    State solution;
-    std::queue<State> open;
-#ifdef CLOSED_USE_VECTOR
-    std::vector<State> closed;
-#else
-    std::unordered_set<State> closed;
-#endif
+    Visited visited;
+    Index next = 0; // the first state not expanded yet
+    Index solution = Visited::none;
+};
+
+// Breadth first search from both the start and the end, one level at a time
+// from the side with the smaller frontier, until the two searches meet:
+// with b successors per state and a solution of d moves, it visits about
+// 2 b^(d/2) states instead of b^d.
+// The moves must be reversible: the predecessors of a state are the ones it
+// can move to.
+
+template <class State>
+class BidirectionalBreadthFirst
+{
+public:
+    BidirectionalBreadthFirst(const State& start, const State& end)
+    {
+        sides[0].visited.Add(start, Visited::none);
+        sides[1].visited.Add(end, Visited::none);
+    }
+    bool Solve()
+    {
+        if (sides[0].visited[0] == sides[1].visited[0])
+        {
+            meeting[0] = meeting[1] = 0;
+            return true;
+        }
+        while (sides[0].Frontier() > 0 && sides[1].Frontier() > 0)
+        {
+            const int side = sides[0].Frontier() <= sides[1].Frontier() ? 0 : 1;
+            if (ExpandLevel(side))
+                return true;
+        }
+        return false;
+    }
+    // the states from the start to the end (only the start if not solved)
+    std::vector<State> Path() const
+    {
+        std::vector<State> path;
+        if (meeting[0] == Visited::none)
+            return { sides[0].visited[0] };
+        for (Index i = meeting[0]; i != Visited::none; i = sides[0].visited.ParentOf(i))
+            path.push_back(sides[0].visited[i]);
+        std::reverse(path.begin(), path.end());
+        for (Index i = sides[1].visited.ParentOf(meeting[1]); i != Visited::none; i = sides[1].visited.ParentOf(i))
+            path.push_back(sides[1].visited[i]);
+        return path;
+    }
+    unsigned long long Expanded() const { return sides[0].level + sides[1].level; }
+    std::size_t Memory() const
+    {
+        return sides[0].visited.Memory() + sides[1].visited.Memory() +
+               sides[0].visited.PreallocatedMemory() + sides[1].visited.PreallocatedMemory();
+    }
+    void PrintStatistics() const
+    {
+        const std::size_t states = sides[0].visited.Size() + sides[1].visited.Size();
+        std::cout << "Visited states: " << states << " (" << sides[0].visited.Size() << " forward, "
+                  << sides[1].visited.Size() << " backward)" << std::endl;
+        PrintMemory(states, sides[0].visited.Memory() + sides[1].visited.Memory(),
+                    sides[0].visited.PreallocatedMemory() + sides[1].visited.PreallocatedMemory());
+    }
+private:
+    using Visited = VisitedStates<State>;
+    using Index = typename Visited::Index;
+
+    struct Side
+    {
+        Visited visited;
+        Index level = 0; // the first state of the last level
+        int depth = 0;   // of the last level
+        std::size_t Frontier() const { return visited.Size() - level; }
+    };
+
+    // Expands the last level of a side. When a new state is visited by the
+    // other side too, the path through it is the shortest among the ones
+    // through this level only if it's the shallowest for the other side,
+    // so the whole level is expanded.
+    bool ExpandLevel(int side)
+    {
+        Side& current = sides[side];
+        const Side& other = sides[1 - side];
+        const Index end = static_cast<Index>(current.visited.Size());
+        int best = std::numeric_limits<int>::max();
+        for (Index i = current.level; i < end; ++i)
+        {
+            const Index parent = current.visited.ParentOf(i);
+            State next[State::maxNext];
+            const int count = current.visited[i].Next(next, parent == Visited::none ? nullptr : &current.visited[parent]);
+            for (int k = 0; k < count; ++k)
+            {
+                const State& s = next[k];
+                if (current.visited.Find(s) != Visited::none)
+                    continue;
+                const Index added = current.visited.Add(s, i);
+                const Index met = other.visited.Find(s);
+                if (met == Visited::none)
+                    continue;
+                const int otherDepth = met < other.level ? other.depth - 1 : other.depth;
+                if (otherDepth < best)
+                {
+                    best = otherDepth;
+                    meeting[side] = added;
+                    meeting[1 - side] = met;
+                }
+            }
+        }
+        current.level = end;
+        ++current.depth;
+        return best != std::numeric_limits<int>::max();
+    }
+
+    Side sides[2]; // forward from the start, backward from the end
+    Index meeting[2] = { Visited::none, Visited::none }; // the same state in the two sides
+};
+
+// Level synchronous breadth first search on threads.
+// The visited states are split in shards by hash, and every shard belongs
+// to one thread, so the visited set needs no locks. Every level is two
+// phases, with the threads joined between them:
+// 1. each thread expands the last level of its shards, and sends every
+//    successor, with the reference to its parent, to the shard it hashes to;
+// 2. each thread adds to its shards the successors sent to them, in the
+//    order of the senders, if not visited yet: they form the next level.
+// The result doesn't depend on the scheduling of the threads.
+// The shards are open addressing tables even for the states with a perfect
+// hash: a table of all the reachable states in every shard would take
+// more memory than the states themselves.
+
+#include <thread>
+
+template <class State>
+class ParallelBreadthFirst
+{
+public:
+    // threads = 0 is the number of cores
+    ParallelBreadthFirst(const State& start, const State& _end, unsigned threads = 0) :
+        end(_end),
+        threadCount(threads != 0 ? threads : std::max(1u, std::thread::hardware_concurrency())),
+        shards(4 * threadCount)
+    {
+        Shard& shard = shards[ShardOf(start)];
+        const Index i = shard.visited.Add(start, none);
+        if (start == end)
+            solution = ReferenceTo(ShardOf(start), i);
+    }
+    bool Solve()
+    {
+        while (solution == none)
+        {
+            std::vector<std::vector<std::vector<Successor>>> sent(threadCount, std::vector<std::vector<Successor>>(shards.size()));
+            RunThreads([&](unsigned t) { Expand(t, sent[t]); });
+            std::vector<Reference> found(threadCount, none);
+            RunThreads([&](unsigned t) { found[t] = Insert(t, sent); });
+            bool empty = true;
+            for (const auto& shard: shards)
+                empty = empty && shard.level == shard.visited.Size();
+            for (auto f: found) // the first shard with the end, in order
+                if (f != none && (solution == none || (f & shardMask) < (solution & shardMask)))
+                    solution = f;
+            if (solution == none && empty)
+                return false;
+        }
+        return true;
+    }
+    // the states from the start to the end (only the start if not solved)
+    std::vector<State> Path() const
+    {
+        std::vector<State> path;
+        Reference r = solution;
+        if (r == none) // the start
+            for (std::size_t s = 0; s < shards.size() && r == none; ++s)
+                if (shards[s].visited.Size() > 0 && shards[s].visited.ParentOf(0) == none)
+                    r = ReferenceTo(s, 0);
+        for (; r != none; r = shards[r & shardMask].visited.ParentOf(static_cast<Index>(r >> shardBits)))
+            path.push_back(shards[r & shardMask].visited[static_cast<Index>(r >> shardBits)]);
+        std::reverse(path.begin(), path.end());
+        return path;
+    }
+    unsigned long long Expanded() const
+    {
+        unsigned long long expanded = 0;
+        for (const auto& shard: shards)
+            expanded += shard.level;
+        return expanded;
+    }
+    std::size_t Memory() const
+    {
+        std::size_t memory = 0;
+        for (const auto& shard: shards)
+            memory += shard.visited.Memory();
+        return memory;
+    }
+    void PrintStatistics() const
+    {
+        std::size_t states = 0;
+        for (const auto& shard: shards)
+            states += shard.visited.Size();
+        std::cout << "Visited states: " << states << " on " << threadCount << " threads" << std::endl;
+        PrintMemory(states, Memory(), 0);
+    }
+private:
+    // a visited state: its index in the shard, then the shard
+    using Reference = std::uint64_t;
+    static constexpr int shardBits = 16;
+    static constexpr Reference shardMask = (1 << shardBits) - 1;
+    static constexpr Reference none = std::numeric_limits<Reference>::max();
+    static Reference ReferenceTo(std::size_t shard, std::uint32_t index) { return (static_cast<Reference>(index) << shardBits) | shard; }
+
+    using Visited = VisitedStates<State, Reference, false>;
+    using Index = typename Visited::Index;
+
+    struct Shard
+    {
+        Visited visited;
+        Index level = 0; // the first state of the last level
+    };
+    struct Successor
+    {
+        State state;
+        Reference parent;
+    };
+
+    std::size_t ShardOf(const State& s) const
+    {
+        // the high bits: the low ones choose the slot in the table of the shard
+        return (std::hash<State>()(s) >> 40) % shards.size();
+    }
+    // the state of a reference, null for none
+    const State* At(Reference r) const
+    {
+        return r == none ? nullptr : &shards[r & shardMask].visited[static_cast<Index>(r >> shardBits)];
+    }
+    template <class F>
+    void RunThreads(F f)
+    {
+        std::vector<std::thread> threads;
+        for (unsigned t = 1; t < threadCount; ++t)
+            threads.emplace_back(f, t);
+        f(0);
+        for (auto& thread: threads)
+            thread.join();
+    }
+    // phase 1 of thread t
+    void Expand(unsigned t, std::vector<std::vector<Successor>>& sent)
+    {
+        for (std::size_t s = t; s < shards.size(); s += threadCount)
+        {
+            const Shard& shard = shards[s];
+            for (Index i = shard.level; i < shard.visited.Size(); ++i)
+            {
+                // the other shards are read only in this phase
+                const State* parent = At(shard.visited.ParentOf(i));
+                State next[State::maxNext];
+                const int count = shard.visited[i].Next(next, parent);
+                for (int k = 0; k < count; ++k)
+                    sent[ShardOf(next[k])].push_back({ next[k], ReferenceTo(s, i) });
+            }
+        }
+    }
+    // phase 2 of thread t: returns the reference of the end if found
+    Reference Insert(unsigned t, const std::vector<std::vector<std::vector<Successor>>>& sent)
+    {
+        Reference found = none;
+        for (std::size_t s = t; s < shards.size(); s += threadCount)
+        {
+            Shard& shard = shards[s];
+            shard.level = static_cast<Index>(shard.visited.Size());
+            for (const auto& fromThread: sent)
+                for (const auto& successor: fromThread[s])
+                {
+                    if (shard.visited.Find(successor.state) != Visited::none)
+                        continue;
+                    const Index i = shard.visited.Add(successor.state, successor.parent);
+                    if (found == none && successor.state == end)
+                        found = ReferenceTo(s, i);
+                }
+        }
+        return found;
+    }
+
+    const State end;
+    const unsigned threadCount;
+    std::vector<Shard> shards;
+    Reference solution = none;
+};
+
+// Iterative deepening A* (Korf, "Depth-first iterative-deepening:
+// an optimal admissible tree search", 1985): a sequence of depth first
+// searches, each one cut where cost + estimate exceeds a bound that is raised
+// to the smallest value exceeding it at every iteration.
+// The memory is only the current path, so it grows with the depth of the
+// solution, and the solution is optimal if the heuristic never overestimates.
+// Heuristic is a function object: int operator()(const State&) returning
+// the estimated number of moves to the end state. By default it's
+// State::EstimatedDistance(end).
+
+template <class State>
+class EstimatedDistance
+{
+public:
+    explicit EstimatedDistance(const State& _end) : end(_end) {}
+    int operator()(const State& s) const { return s.EstimatedDistance(end); }
+private:
+    const State end;
+};
+
+template <class State, class Heuristic = EstimatedDistance<State>>
+class IDAStar
+{
+public:
+    // the search fails if no solution costs less than maxCost
+    IDAStar(const State& _start, const State& _end, int _maxCost = std::numeric_limits<int>::max()) :
+        IDAStar(_start, _end, Heuristic(_end), _maxCost)
+    {}
+    IDAStar(const State& _start, const State& _end, Heuristic _heuristic, int _maxCost = std::numeric_limits<int>::max()) :
+        start(_start), end(_end), heuristic(std::move(_heuristic)), maxCost(_maxCost)
+    {}
+    bool Solve()
+    {
+        int bound = heuristic(start);
+        while (bound < maxCost)
+        {
+            ++iterations;
+            path.assign(1, start);
+            const int next = Search(0, bound);
+            if (next == found)
+                return true;
+            bound = next; // the smallest cost over the bound
+        }
+        return false;
+    }
+    // the states from the start to the end
+    const std::vector<State>& Path() const { return path; }
+    unsigned long long Expanded() const { return expanded; }
+    std::size_t Memory() const { return path.capacity() * sizeof(State); }
+    void PrintStatistics() const
+    {
+        std::cout << "Expanded states: " << expanded << " in " << iterations << " iterations" << std::endl;
+    }
+private:
+    static constexpr int found = -1;
+
+    // depth first search from path.back(), that costs cost so far.
+    // Returns found or the smallest cost exceeding the bound.
+    int Search(int cost, int bound)
+    {
+        const State& current = path.back();
+        const int f = cost + heuristic(current);
+        if (f > bound)
+            return f;
+        if (current == end)
+            return found;
+        ++expanded;
+        int min = std::numeric_limits<int>::max();
+        State next[State::maxNext];
+        const int count = current.Next(next, path.size() > 1 ? &path[path.size() - 2] : nullptr); // don't go back
+        for (int k = 0; k < count; ++k)
+        {
+            path.push_back(next[k]); // current is invalid from here
+            const int t = Search(cost + 1, bound);
+            if (t == found)
+                return found;
+            min = std::min(min, t);
+            path.pop_back();
+        }
+        return min;
+    }
+
+    const State start;
+    const State end;
+    const Heuristic heuristic;
+    const int maxCost;
+    std::vector<State> path;
+    unsigned long long expanded = 0;
+    unsigned iterations = 0;
 };
 
 //
 
 #include <array>
-#include <cassert>
+#include <cstdlib>
 #include <iomanip>
-#include <boost/functional/hash.hpp>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// the positions where the blank can move from each position
+struct BlankMoves
+{
+    int count;
+    int to[4];
+};
+
+template <int Rows, int Cols>
+constexpr std::array<BlankMoves, Rows * Cols> BlankMovesTable()
+{
+    std::array<BlankMoves, Rows * Cols> table = {};
+    for (int pos = 0; pos < Rows * Cols; ++pos)
+    {
+        auto& moves = table[pos];
+        if (pos >= Cols) moves.to[moves.count++] = pos - Cols;              // up
+        if (pos % Cols > 0) moves.to[moves.count++] = pos - 1;              // left
+        if (pos % Cols < Cols - 1) moves.to[moves.count++] = pos + 1;       // right
+        if (pos < (Rows - 1) * Cols) moves.to[moves.count++] = pos + Cols;  // down
+    }
+    return table;
+}
 
-class FState
+static_assert(BlankMovesTable<4, 4>()[0].count == 2 && BlankMovesTable<4, 4>()[5].count == 4 &&
+              BlankMovesTable<4, 4>()[15].to[1] == 14, "wrong blank moves");
+
+constexpr std::size_t Factorial(int n)
+{
+    return n <= 1 ? 1 : n * Factorial(n - 1);
+}
+
+constexpr int BitsFor(int n) // to write 0 ... n - 1
+{
+    return n <= 2 ? 1 : 1 + BitsFor((n + 1) / 2);
+}
+
+// A sliding puzzle of Rows x Cols positions, at most 64.
+// The tiles are packed in 64 bit words, with the bits needed for the
+// biggest tile: the tile in position i (0 is the blank) is the field
+// i % perWord of the word i / perWord, counting from the least significant.
+// The 8 and 15 puzzles fit in one word, the 24 puzzle in three.
+// The goal is 1, 2, ..., Rows * Cols - 1, blank.
+// A state doesn't remember how it was reached: the searches keep the path.
+
+template <int Rows, int Cols>
+class SlidingState
 {
 public:
-    FState() : configuration( {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 0} )
-    {
-    }    
-    FState(std::array<int, 16>&& s) : configuration(std::move(s)) {}
-    FState(const FState& s) : configuration(s.configuration), moves(s.moves) {}
-    FState(FState&& s) : configuration(std::move(s.configuration)), moves(std::move(s.moves)) {}
-    FState& operator = (const FState& s)
-    { 
-        if (&s != this)
-        {
-            configuration = s.configuration;
-            moves = s.moves;
-        }
-        return *this;
-    }    
-    std::vector<FState> Next() const
-    {
-        auto emptyIt = std::find(configuration.begin(), configuration.end(), 0);
-        auto emptyPosition = emptyIt - configuration.begin();
-        using V = std::vector<FState>;
-        switch (emptyPosition)
-        {
-            case 0: return V{ Move(0, 1), Move(0, 4) }; break;
-            case 1: return V{ Move(1, 0), Move(1, 5), Move(1, 2) }; break;
-            case 2: return V{ Move(2, 1), Move(2, 6), Move(2, 3) }; break;
-            case 3: return V{ Move(3, 2), Move(3, 7) }; break;
-            case 4: return V{ Move(4, 0), Move(4, 5), Move(4, 8) }; break;
-            case 5: return V{ Move(5, 1), Move(5, 4), Move(5, 6), Move(5, 9) }; break;
-            case 6: return V{ Move(6, 2), Move(6, 5), Move(6, 7), Move(6, 10) }; break;
-            case 7: return V{ Move(7, 3), Move(7, 6), Move(7, 11) }; break;
-            case 8: return V{ Move(8, 4), Move(8, 9), Move(8, 12) }; break;
-            case 9: return V{ Move(9, 5), Move(9, 8), Move(9, 10), Move(9, 13) }; break;
-            case 10: return V{ Move(10, 6), Move(10, 9), Move(10, 11), Move(10, 14) }; break;
-            case 11: return V{ Move(11, 7), Move(11, 10), Move(11, 15) }; break;
-            case 12: return V{ Move(12, 8), Move(12, 13)}; break;
-            case 13: return V{ Move(13, 12), Move(13, 9), Move(13, 14) }; break;
-            case 14: return V{ Move(14, 13), Move(14, 10), Move(14, 15) }; break;
-            case 15: return V{ Move(15, 11), Move(15, 14)}; break;
-            default: assert(false);
-        }
-        return {};
-    }
-    bool operator == (const FState& other) const
-    {
-        return configuration == other.configuration;
+    static constexpr int rows = Rows;
+    static constexpr int cols = Cols;
+    static constexpr int cells = Rows * Cols;
+    static_assert(Rows >= 2 && Cols >= 2 && cells <= 64, "unsupported board");
+
+    SlidingState() : words(goalWords) {} // the goal
+    SlidingState(std::array<int, cells>&& s) : words{}
+    {
+        for (int i = 0; i < cells; ++i)
+            Set(i, s[i]);
+    }
+    static constexpr int maxNext = 4;
+    // Writes the states one move away in next, but parent if not null,
+    // and returns how many they are.
+    int Next(SlidingState (&next)[maxNext], const SlidingState* parent = nullptr) const
+    {
+        const int blank = Blank();
+        const int back = parent != nullptr ? parent->Blank() : -1; // where the blank comes from
+        const auto& moves = blankMoves[blank];
+        int count = 0;
+        for (int i = 0; i < moves.count; ++i)
+            if (moves.to[i] != back)
+                next[count++] = Move(blank, moves.to[i]);
+        return count;
+    }
+    bool operator == (const SlidingState& other) const
+    {
+        for (int i = 0; i < wordCount; ++i)
+            if (words[i] != other.words[i])
+                return false;
+        return true;
     }
     void Print() const
     {
         std::cout << std::endl;
-        PrintItem(0);
-        PrintItem(1);
-        PrintItem(2);
-        PrintItem(3);
-        std::cout << std::endl;
-        PrintItem(4);
-        PrintItem(5);
-        PrintItem(6);
-        PrintItem(7);
-        std::cout << std::endl;
-        PrintItem(8);
-        PrintItem(9);
-        PrintItem(10);
-        PrintItem(11);        
-        std::cout << std::endl;
-        PrintItem(12);
-        PrintItem(13);
-        PrintItem(14);
-        PrintItem(15);
-        std::cout << std::endl;
+        for (int row = 0; row < Rows; ++row)
+        {
+            for (int col = 0; col < Cols; ++col)
+                PrintItem(row * Cols + col);
+            std::cout << std::endl;
+        }
     }
-    void PrintMoves() const
+    // the tiles packed, 4 bits each (only the boards of one word)
+    std::uint64_t Packed() const
     {
-        for (auto move: moves)
-            std::cout << move << ' ';
-        std::cout << std::endl;
+        static_assert(wordCount == 1, "the board doesn't fit in a word");
+        return words[0];
     }
+    int Tile(int pos) const
+    {
+        return static_cast<int>((words[pos / perWord] >> (bits * (pos % perWord))) & mask);
+    }
+    int Blank() const
+    {
+        if constexpr (wordCount == 1 && bits == 4)
+        {
+            // the first nibble with no bits set (the ones after the board are 0 too)
+            std::uint64_t x = words[0] | (words[0] >> 1);
+            x |= x >> 2;
+            x = ~x & 0x1111111111111111ull; // bit 4 * blank
+#ifdef _MSC_VER
+            unsigned long bit;
+            _BitScanForward64(&bit, x);
+            return static_cast<int>(bit) / 4;
+#else
+            return __builtin_ctzll(x) / 4;
+#endif
+        }
+        else
+        {
+            int pos = 0;
+            while (Tile(pos) != 0)
+                ++pos;
+            return pos;
+        }
+    }
+    // the finalizer of MurmurHash3 on each word: all the bits reach the low bits
     std::size_t Hash() const
     {
-        return boost::hash_range(std::begin(configuration), std::end(configuration));
+        std::uint64_t h = 0;
+        for (auto w: words)
+        {
+            h ^= w;
+            h ^= h >> 33;
+            h *= 0xff51afd7ed558ccdull;
+            h ^= h >> 33;
+        }
+        return static_cast<std::size_t>(h);
+    }
+
+    // The boards of up to 10 positions have a perfect hash of the states
+    // reachable from the goal (half of the permutations): the position of
+    // the blank, then the rank of the order of the tiles without the last
+    // two, that are fixed by the parity of the permutation.
+    static constexpr std::size_t perfectHashSize = cells <= 10 ? Factorial(cells) / 2 : 0;
+    std::size_t PerfectHash() const
+    {
+        static_assert(perfectHashSize != 0, "the board is too big for a perfect hash");
+        int tiles[cells];
+        int count = 0;
+        int blank = 0;
+        for (int pos = 0; pos < cells; ++pos)
+        {
+            const int tile = Tile(pos);
+            if (tile == 0)
+                blank = pos;
+            else
+                tiles[count++] = tile;
+        }
+        std::size_t rank = 0;
+        for (int i = 0; i < cells - 3; ++i)
+        {
+            int smaller = 0; // after it
+            for (int j = i + 1; j < cells - 1; ++j)
+                smaller += tiles[j] < tiles[i] ? 1 : 0;
+            rank = rank * (cells - 1 - i) + smaller;
+        }
+        return blank * (Factorial(cells - 1) / 2) + rank;
+    }
+
+    // True if the goal can be reached: a move along a row keeps the order of
+    // the tiles, a move along a column passes a tile over Cols - 1 others.
+    // So, with Cols odd, the parity of the inversions never changes, and with
+    // Cols even it changes with the row of the blank. The goal has none and
+    // the blank in the last row.
+    bool Solvable() const
+    {
+        int inversions = 0;
+        for (int i = 0; i < cells; ++i)
+            for (int j = i + 1; j < cells; ++j)
+                inversions += Tile(i) != 0 && Tile(j) != 0 && Tile(j) < Tile(i) ? 1 : 0;
+        const int blankRows = Cols % 2 == 0 ? Rows - 1 - Blank() / Cols : 0; // from the last row
+        return (inversions + blankRows) % 2 == 0;
+    }
+
+    // Lower bound of the moves to reach goal: Manhattan distance of the tiles
+    // plus their linear conflicts (Hansson, Mayer, Yung 1992).
+    int EstimatedDistance(const SlidingState& goal) const
+    {
+        std::array<int, cells> goalPosition;
+        for (int i = 0; i < cells; ++i)
+            goalPosition[goal.Tile(i)] = i;
+        return ManhattanDistance(goalPosition) + LinearConflict(goalPosition);
     }
 private:
-    void PrintItem(std::size_t pos) const
+    static constexpr int bits = BitsFor(cells) < 4 ? 4 : BitsFor(cells);
+    static constexpr int perWord = 64 / bits;
+    static constexpr int wordCount = (cells + perWord - 1) / perWord;
+    static constexpr std::uint64_t mask = (1ull << bits) - 1;
+    using Words = std::array<std::uint64_t, wordCount>;
+
+    static constexpr Words GoalWords()
+    {
+        Words w = {};
+        for (int pos = 0; pos < cells - 1; ++pos)
+            w[pos / perWord] |= static_cast<std::uint64_t>(pos + 1) << (bits * (pos % perWord));
+        return w;
+    }
+    static constexpr Words goalWords = GoalWords();
+    static constexpr auto blankMoves = BlankMovesTable<Rows, Cols>();
+
+    void Set(int pos, int tile)
+    {
+        auto& w = words[pos / perWord];
+        const int shift = bits * (pos % perWord);
+        w = (w & ~(mask << shift)) | ((static_cast<std::uint64_t>(tile) & mask) << shift);
+    }
+    // sum of the distances of the tiles (not the blank) from their goal positions
+    int ManhattanDistance(const std::array<int, cells>& goalPosition) const
+    {
+        int distance = 0;
+        for (int i = 0; i < cells; ++i)
+        {
+            const int tile = Tile(i);
+            if (tile == 0)
+                continue;
+            const int g = goalPosition[tile];
+            distance += std::abs(i / Cols - g / Cols) + std::abs(i % Cols - g % Cols);
+        }
+        return distance;
+    }
+    // Two tiles in their goal row (or column), in the wrong order, need two more
+    // moves than the Manhattan distance for one of them to step aside.
+    // For each line: 2 * the tiles to remove so that the remaining ones are
+    // in order (the ones not in the longest increasing subsequence).
+    int LinearConflict(const std::array<int, cells>& goalPosition) const
+    {
+        int extra = 0;
+        for (int row = 0; row < Rows; ++row)
+        {
+            int targets[Cols]; // goal columns of the tiles of this row whose goal is this row
+            int count = 0;
+            for (int col = 0; col < Cols; ++col)
+            {
+                const int tile = Tile(row * Cols + col);
+                if (tile != 0 && goalPosition[tile] / Cols == row)
+                    targets[count++] = goalPosition[tile] % Cols;
+            }
+            extra += 2 * (count - LongestIncreasing(targets, count));
+        }
+        for (int col = 0; col < Cols; ++col)
+        {
+            int targets[Rows]; // goal rows of the tiles of this column whose goal is this column
+            int count = 0;
+            for (int row = 0; row < Rows; ++row)
+            {
+                const int tile = Tile(row * Cols + col);
+                if (tile != 0 && goalPosition[tile] % Cols == col)
+                    targets[count++] = goalPosition[tile] / Cols;
+            }
+            extra += 2 * (count - LongestIncreasing(targets, count));
+        }
+        return extra;
+    }
+    static int LongestIncreasing(const int* v, int n)
+    {
+        int length[Rows > Cols ? Rows : Cols];
+        int result = 0;
+        for (int i = 0; i < n; ++i)
+        {
+            length[i] = 1;
+            for (int j = 0; j < i; ++j)
+                if (v[j] < v[i])
+                    length[i] = std::max(length[i], length[j] + 1);
+            result = std::max(result, length[i]);
+        }
+        return result;
+    }
+    void PrintItem(int pos) const
     {
         std::cout << std::setw(3);
-        std::cout << configuration[pos];
+        std::cout << Tile(pos);
     }
-    FState Move(std::size_t pivot, std::size_t item) const
+    // moves the tile in item to the blank in pivot
+    SlidingState Move(int pivot, int item) const
     {
-        auto cfg = *this;
-        std::swap(cfg.configuration[pivot], cfg.configuration[item]);
-        cfg.moves.push_back(item);
-        return cfg;
+        SlidingState s(*this);
+        const std::uint64_t tile = Tile(item);
+        if constexpr (wordCount == 1)
+            s.words[0] = (words[0] & ~(mask << (bits * item))) | (tile << (bits * pivot));
+        else
+        {
+            s.Set(pivot, static_cast<int>(tile));
+            s.Set(item, 0);
+        }
+        return s;
     }
 
-    std::array<int, 16> configuration;
-    std::vector<int> moves;
+    Words words;
 };
 
+using EightState = SlidingState<3, 3>;
+using FState = SlidingState<4, 4>;
+using TwentyFourState = SlidingState<5, 5>;
+
+static_assert(sizeof(FState) == 8 && sizeof(EightState) == 8 && sizeof(TwentyFourState) == 24, "wrong packing");
+
+// the positions the blank moves to along the path
+template <int Rows, int Cols>
+void PrintMoves(const std::vector<SlidingState<Rows, Cols>>& path)
+{
+    for (std::size_t i = 1; i < path.size(); ++i)
+        std::cout << path[i].Blank() << ' ';
+    std::cout << std::endl;
+}
+
 // custom specialization of std::hash can be injected in namespace std
 namespace std
 {
-    template<> struct hash<FState>
+    template<int Rows, int Cols> struct hash<SlidingState<Rows, Cols>>
     {
-        typedef FState argument_type;
+        typedef SlidingState<Rows, Cols> argument_type;
         typedef std::size_t result_type;
         result_type operator()(argument_type const& s) const noexcept
         {
@@ -212,37 +947,662 @@ namespace std
     };
 }
 
+// Additive pattern databases (Korf, Felner, "Disjoint pattern database
+// heuristics", 2002).
+// The tiles are split in disjoint patterns: the database of a pattern holds,
+// for every placement of its tiles, the moves of those tiles needed to bring
+// them to their goal positions, whatever the other tiles do. Only the moves
+// of the pattern tiles are counted, so the sum over the patterns is a lower
+// bound of the moves of the whole puzzle.
+// The tables are built by a breadth first search backward from the goal,
+// one byte per placement, and saved in a file that the solvers map in memory.
+
+#include <atomic>
+#include <bitset>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+namespace Pdb
+{
+    // a pattern is a set of tiles: bit t for the tile t
+    using Pattern = std::uint16_t;
+
+    // the partitions of the 15 tiles (Korf, Felner)
+    inline std::vector<Pattern> Partition(const std::string& name)
+    {
+        const auto pattern = [](std::initializer_list<int> tiles)
+        {
+            Pattern p = 0;
+            for (auto t: tiles)
+                p |= 1 << t;
+            return p;
+        };
+        if (name == "6-6-3")
+            return { pattern({1, 5, 6, 9, 10, 13}), pattern({7, 8, 11, 12, 14, 15}), pattern({2, 3, 4}) };
+        if (name == "7-8")
+            return { pattern({1, 5, 6, 9, 10, 13, 14}), pattern({2, 3, 4, 7, 8, 11, 12, 15}) };
+        throw std::runtime_error("Unknown partition " + name + ": use 6-6-3 or 7-8");
+    }
+
+    inline int Size(Pattern pattern) { return static_cast<int>(std::bitset<16>(pattern).count()); }
+
+    // placements of k tiles in 16 positions: 16! / (16 - k)!
+    inline std::size_t Placements(int k)
+    {
+        std::size_t n = 1;
+        for (int i = 0; i < k; ++i)
+            n *= 16 - i;
+        return n;
+    }
+
+    // Index of the placement of k tiles in [0, Placements(k)):
+    // the position of each tile counted among the ones still free.
+    inline std::size_t Rank(const int* positions, int k)
+    {
+        std::size_t index = 0;
+        unsigned used = 0;
+        for (int i = 0; i < k; ++i)
+        {
+            const unsigned below = used & ((1u << positions[i]) - 1);
+            index = index * (16 - i) + positions[i] - std::bitset<16>(below).count();
+            used |= 1u << positions[i];
+        }
+        return index;
+    }
+
+    // the positions next to the ones in the mask (bit i for the position i)
+    inline unsigned Neighbours(unsigned cells)
+    {
+        return (((cells << 1) & 0xEEEE) | ((cells >> 1) & 0x7777) | (cells << 4) | (cells >> 4)) & 0xFFFF;
+    }
+
+    // the positions where the blank can go without moving a tile in occupied
+    inline unsigned Region(int blank, unsigned occupied)
+    {
+        const unsigned free = ~occupied & 0xFFFF;
+        unsigned region = 1u << blank;
+        while (true)
+        {
+            const unsigned grown = region | (Neighbours(region) & free);
+            if (grown == region)
+                return region;
+            region = grown;
+        }
+    }
+
+    inline int LowestBit(unsigned x)
+    {
+        int bit = 0;
+        while ((x & 1) == 0)
+        {
+            x >>= 1;
+            ++bit;
+        }
+        return bit;
+    }
+
+    // The distances of a pattern from its goal placement, 0xFF if unknown.
+    // The search is on the placements of the pattern tiles plus the blank:
+    // the moves of the other tiles cost nothing, so a node is a placement and
+    // the region the blank can reach from there for free, and the distance
+    // of a placement is the one of the first node found with it.
+    // A node is queued as 4 bits per tile position, then the region mask.
+    inline std::vector<std::uint8_t> Build(Pattern pattern, const FState& goal)
+    {
+        // the goal positions of the tiles, in increasing order of tile
+        int start[16];
+        int k = 0;
+        for (int t = 0; t < 16; ++t)
+            for (int pos = 0; pos < 16; ++pos)
+                if ((pattern & (1 << t)) && goal.Tile(pos) == t)
+                    start[k++] = pos;
+
+        std::vector<std::uint8_t> distance(Placements(k), 0xFF);
+        std::vector<std::uint64_t> visited((distance.size() * 16 + 63) / 64); // placement, lowest position of the region
+
+        const auto encode = [k](const int* positions, unsigned region)
+        {
+            std::uint64_t node = region;
+            for (int i = 0; i < k; ++i)
+                node |= static_cast<std::uint64_t>(positions[i]) << (16 + 4 * i);
+            return node;
+        };
+        const auto occupiedBy = [k](const int* positions)
+        {
+            unsigned occupied = 0;
+            for (int i = 0; i < k; ++i)
+                occupied |= 1u << positions[i];
+            return occupied;
+        };
+        // true the first time the node is seen
+        const auto visit = [&](const int* positions, unsigned region, int d)
+        {
+            const std::size_t index = Rank(positions, k);
+            const std::size_t bit = index * 16 + LowestBit(region);
+            if (visited[bit / 64] & (1ull << (bit % 64)))
+                return false;
+            visited[bit / 64] |= 1ull << (bit % 64);
+            if (distance[index] == 0xFF)
+                distance[index] = static_cast<std::uint8_t>(d);
+            return true;
+        };
+
+        const unsigned startRegion = Region(goal.Blank(), occupiedBy(start));
+        visit(start, startRegion, 0);
+        std::vector<std::uint64_t> level{ encode(start, startRegion) };
+        std::vector<std::uint64_t> nextLevel;
+        for (int d = 1; !level.empty(); ++d)
+        {
+            for (auto node: level)
+            {
+                int positions[16];
+                for (int i = 0; i < k; ++i)
+                    positions[i] = static_cast<int>((node >> (16 + 4 * i)) & 0xF);
+                const unsigned region = node & 0xFFFF;
+                const unsigned occupied = occupiedBy(positions);
+                // a tile next to the region moves into it, and the blank takes its place
+                for (int i = 0; i < k; ++i)
+                {
+                    const int from = positions[i];
+                    const unsigned cell = 1u << from;
+                    const unsigned targets = region & Neighbours(cell);
+                    for (int to = 0; to < 16; ++to)
+                    {
+                        if ((targets & (1u << to)) == 0)
+                            continue;
+                        positions[i] = to;
+                        const unsigned nextRegion = Region(from, occupied ^ cell ^ (1u << to));
+                        if (visit(positions, nextRegion, d))
+                            nextLevel.push_back(encode(positions, nextRegion));
+                    }
+                    positions[i] = from;
+                }
+            }
+            level.swap(nextLevel);
+            nextLevel.clear();
+        }
+        return distance;
+    }
+
+    // the file: this header, then the tables of the patterns in order
+    struct Header
+    {
+        char magic[8];
+        std::uint64_t goal;  // FState::Packed() of the goal
+        std::uint64_t count; // of the patterns
+        Pattern patterns[4];
+    };
+    constexpr char magic[8] = { 'F', 'P', 'D', 'B', '1', 0, 0, 0 };
+
+    // builds the tables of the partition and saves them in fileName
+    inline void Save(const std::string& fileName, const std::vector<Pattern>& partition, const FState& goal)
+    {
+        if (partition.size() > 4)
+            throw std::runtime_error("Too many patterns");
+        Header header = {};
+        std::copy(std::begin(magic), std::end(magic), header.magic);
+        header.goal = goal.Packed();
+        header.count = partition.size();
+        std::copy(partition.begin(), partition.end(), header.patterns);
+        std::ofstream out(fileName, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        for (auto pattern: partition)
+        {
+            const auto table = Build(pattern, goal);
+            out.write(reinterpret_cast<const char*>(table.data()), table.size());
+        }
+        out.close();
+        if (!out)
+            throw std::runtime_error("Can't write " + fileName);
+    }
+} // Pdb
+
+// The heuristic of the pattern databases in a file written by Pdb::Save.
+// The file is mapped in memory, not read: opening it is immediate, and the
+// pages of the tables are loaded by the system when they're used.
+class PatternDatabase
+{
+public:
+    // throws std::runtime_error if the file is not valid, or is for another goal
+    PatternDatabase(const std::string& fileName, const FState& goal)
+    {
+        try
+        {
+            file = boost::interprocess::file_mapping(fileName.c_str(), boost::interprocess::read_only);
+            region = boost::interprocess::mapped_region(file, boost::interprocess::read_only);
+        }
+        catch (const boost::interprocess::interprocess_exception& e)
+        {
+            throw std::runtime_error("Can't open " + fileName + ": " + e.what());
+        }
+        const auto data = static_cast<const std::uint8_t*>(region.get_address());
+        Pdb::Header header;
+        if (region.get_size() < sizeof(header))
+            throw std::runtime_error(fileName + " is not a pattern database");
+        std::copy(data, data + sizeof(header), reinterpret_cast<std::uint8_t*>(&header));
+        if (!std::equal(std::begin(Pdb::magic), std::end(Pdb::magic), header.magic) || header.count > 4)
+            throw std::runtime_error(fileName + " is not a pattern database");
+        if (header.goal != goal.Packed())
+            throw std::runtime_error(fileName + " is a pattern database for another goal");
+
+        std::size_t offset = sizeof(header);
+        for (std::size_t i = 0; i < header.count; ++i)
+        {
+            Table table;
+            for (int t = 0; t < 16; ++t)
+                if (header.patterns[i] & (1 << t))
+                    table.tiles[table.size++] = t;
+            table.distance = data + offset;
+            offset += Pdb::Placements(table.size);
+            tables.push_back(table);
+        }
+        if (offset != region.get_size())
+            throw std::runtime_error(fileName + " is truncated");
+    }
+    PatternDatabase(const PatternDatabase&) = delete;
+    PatternDatabase& operator = (const PatternDatabase&) = delete;
+
+    // the sum of the distances of the patterns
+    int operator()(const FState& s) const
+    {
+        int position[16];
+        for (int pos = 0; pos < 16; ++pos)
+            position[s.Tile(pos)] = pos;
+        int distance = 0;
+        for (const auto& table: tables)
+        {
+            int positions[16];
+            for (int i = 0; i < table.size; ++i)
+                positions[i] = position[table.tiles[i]];
+            distance += table.distance[Pdb::Rank(positions, table.size)];
+        }
+        return distance;
+    }
+private:
+    struct Table
+    {
+        int tiles[16]; // in increasing order
+        int size = 0;
+        const std::uint8_t* distance = nullptr;
+    };
+
+    boost::interprocess::file_mapping file;
+    boost::interprocess::mapped_region region;
+    std::vector<Table> tables;
+};
+
 #include <boost/chrono/chrono.hpp>
 #include <boost/chrono/process_cpu_clocks.hpp>
+#include <boost/chrono/thread_clock.hpp>
 
 using namespace boost::chrono;
 
-int main()
+template <class Search>
+bool Run(const char* name, Search& search)
 {
-    //const FState start( std::array<int, 16>({1,12,6,4,9,7,11,10,15,3,2,13,5,8,14,0}) );
-    const FState start( std::array<int, 16>({2,3,7,4,1,0,11,8,5,6,10,12,9,13,14,15}) );
-    const FState goal;
-    BreadthFirst<FState> search(start, goal);
-    
+    std::cout << name << ":" << std::endl;
     auto t0 = process_user_cpu_clock::now(); // boost
+    auto wall0 = steady_clock::now();
     
     bool found = search.Solve();
 
     auto t1 = process_user_cpu_clock::now(); // boost   
     using ms = boost::chrono::milliseconds;
     ms d = boost::chrono::duration_cast<ms>(t1-t0); 
-    std::cout << d.count() << " ms" << std::endl;
+    ms wall = boost::chrono::duration_cast<ms>(steady_clock::now() - wall0);
+    std::cout << d.count() << " ms (" << wall.count() << " ms elapsed)" << std::endl;
 
     if (found)
     {
         std::cout << "Solution found:" << std::endl;
-        search.Solution().PrintMoves();        
+        PrintMoves(search.Path());
     }
     else
     {
         std::cout << "Solution not found!" << std::endl;
     }
     search.PrintStatistics();
+    return found;
+}
+
+using Ms = boost::chrono::duration<double, boost::milli>;
+
+// Batch mode (--batch=FILE): many instances solved on a pool of threads.
+
+struct BatchResult
+{
+    int moves = -1; // -1 if not solved
+    double cpuMs = 0; // of the thread solving it
+    double wallMs = 0;
+    unsigned long long expanded = 0;
+    std::size_t memory = 0; // of the search
+};
+
+template <class Search>
+BatchResult Measure(Search& search)
+{
+    BatchResult result;
+    const auto cpu0 = thread_clock::now();
+    const auto wall0 = steady_clock::now();
+    if (search.Solve())
+        result.moves = static_cast<int>(search.Path().size()) - 1;
+    result.cpuMs = Ms(thread_clock::now() - cpu0).count();
+    result.wallMs = Ms(steady_clock::now() - wall0).count();
+    result.expanded = search.Expanded();
+    result.memory = search.Memory();
+    return result;
+}
+
+// the state of tiles, that has State::cells of them
+template <class State>
+State MakeState(const std::vector<int>& tiles)
+{
+    std::array<int, State::cells> a;
+    std::copy(tiles.begin(), tiles.end(), a.begin());
+    return State(std::move(a));
+}
+
+// true if the tiles (9, 16 or 25 of them) can reach the goal
+bool Solvable(const std::vector<int>& tiles)
+{
+    switch (tiles.size())
+    {
+    case 9: return MakeState<EightState>(tiles).Solvable();
+    case 16: return MakeState<FState>(tiles).Solvable();
+    case 25: return MakeState<TwentyFourState>(tiles).Solvable();
+    }
+    return false;
+}
+
+struct Instance
+{
+    std::vector<int> tiles;
+    int number; // from the comment "# number:" of its line, else its position in the file
+};
+
+// One instance per line: the tiles (9, 16 or 25), 0 is the blank,
+// all the lines of the same size, that can reach the goal.
+// Empty lines and the text after a # are ignored, but the number of the
+// instance in "# number:".
+std::vector<Instance> ReadInstances(const std::string& fileName)
+{
+    std::ifstream in(fileName);
+    if (!in)
+        throw std::runtime_error("Can't open " + fileName);
+    std::vector<Instance> instances;
+    std::string line;
+    for (int lineNumber = 1; std::getline(in, line); ++lineNumber)
+    {
+        std::istringstream tiles(line.substr(0, line.find('#')));
+        std::vector<int> a;
+        for (int tile; tiles >> tile; )
+            a.push_back(tile);
+        if (a.empty() && tiles.eof())
+            continue;
+        const std::size_t size = instances.empty() ? a.size() : instances[0].tiles.size();
+        std::vector<bool> seen(size, false);
+        for (auto tile: a)
+            if (tile >= 0 && static_cast<std::size_t>(tile) < size)
+                seen[tile] = true;
+        if (!tiles.eof() || a.size() != size || (size != 9 && size != 16 && size != 25) ||
+            std::find(seen.begin(), seen.end(), false) != seen.end())
+            throw std::runtime_error(fileName + ":" + std::to_string(lineNumber) + ": expecting the " +
+                                     (instances.empty() ? std::string("9, 16 or 25") : std::to_string(size)) +
+                                     " tiles 0-" + (instances.empty() ? std::string("N") : std::to_string(size - 1)));
+        if (!Solvable(a))
+            throw std::runtime_error(fileName + ":" + std::to_string(lineNumber) + ": the instance can't reach the goal");
+        int number = static_cast<int>(instances.size()) + 1;
+        const std::size_t comment = line.find('#');
+        if (comment != std::string::npos)
+        {
+            std::istringstream text(line.substr(comment + 1));
+            int n;
+            char colon;
+            if (text >> n >> colon && colon == ':')
+                number = n;
+        }
+        instances.push_back({ std::move(a), number });
+    }
+    return instances;
+}
 
+// peak resident memory of the process in KB, 0 if unknown
+std::size_t PeakMemory()
+{
+#ifdef __linux__
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line))
+        if (line.rfind("VmHWM:", 0) == 0)
+            return std::stoul(line.substr(6));
+#endif
     return 0;
-}
\ No newline at end of file
+}
+
+// Solves the instances on jobs threads, each one taking the next instance
+// not solved yet, and prints a line per instance (in the order of the file,
+// with its number in numbers) and the totals.
+// Returns true if all the instances are solved.
+template <class State, class Solve>
+bool RunBatch(const std::vector<State>& instances, const std::vector<int>& numbers, unsigned jobs, Solve solve)
+{
+    std::vector<BatchResult> results(instances.size());
+    std::atomic<std::size_t> next{ 0 };
+    const auto worker = [&]()
+    {
+        for (std::size_t i = next++; i < instances.size(); i = next++)
+            results[i] = solve(instances[i]);
+    };
+    const auto wall0 = steady_clock::now();
+    std::vector<std::thread> threads;
+    for (unsigned t = 1; t < jobs; ++t)
+        threads.emplace_back(worker);
+    worker();
+    for (auto& thread: threads)
+        thread.join();
+    const double seconds = Ms(steady_clock::now() - wall0).count() / 1000;
+
+    std::cout << std::setw(8) << "instance" << std::setw(7) << "moves" << std::setw(12) << "cpu ms"
+              << std::setw(12) << "wall ms" << std::setw(14) << "expanded" << std::setw(12) << "memory KB" << "\n";
+    std::size_t solved = 0;
+    unsigned long long expanded = 0;
+    double cpuMs = 0;
+    std::cout << std::fixed << std::setprecision(1);
+    for (std::size_t i = 0; i < results.size(); ++i)
+    {
+        const auto& r = results[i];
+        std::cout << std::setw(8) << numbers[i] << std::setw(7) << r.moves << std::setw(12) << r.cpuMs
+                  << std::setw(12) << r.wallMs << std::setw(14) << r.expanded
+                  << std::setw(12) << (r.memory + 1023) / 1024 << "\n";
+        solved += r.moves >= 0 ? 1 : 0;
+        expanded += r.expanded;
+        cpuMs += r.cpuMs;
+    }
+    std::cout << "Solved " << solved << " of " << instances.size() << " instances in "
+              << std::setprecision(3) << seconds << " s on " << jobs << " threads (" << cpuMs / 1000 << " s cpu)\n"
+              << std::setprecision(1) << instances.size() / seconds << " instances/s, "
+              << expanded / seconds << " expanded states/s\n";
+    std::cout.unsetf(std::ios::floatfield);
+    const std::size_t peak = PeakMemory();
+    std::cout << "Peak memory: ";
+    if (peak != 0)
+        std::cout << peak << " KB" << std::endl;
+    else
+        std::cout << "unknown" << std::endl;
+    return solved == instances.size();
+}
+
+// fifteen [--search=ida|bfs|bidirectional|parallel] [--threads=N] [--pdb=FILE] [9, 16 or 25 tiles, 0 is the blank]
+// fifteen --batch=FILE [--jobs=N] [--search=...] [--threads=N] [--pdb=FILE]
+// fifteen --build-pdb=FILE [--partition=6-6-3|7-8]
+// Without tiles, solves the builtin start with all the searches,
+// otherwise solves the start passed with the one of --search (IDA* by default).
+// The number of tiles chooses the board: 3x3, 4x4 or 5x5.
+// --threads is for the parallel breadth first (the number of cores by default).
+// --batch solves the instances of FILE (korf100.txt is the reference set)
+// on --jobs threads (the number of cores by default), and reports each one.
+// --pdb uses the pattern databases of FILE as the heuristic of IDA* (4x4 only),
+// --build-pdb builds them (6-6-3 by default) and saves them in FILE.
+int main(int argc, char* argv[])
+{
+    try
+    {
+        std::string pdbFile;
+        std::string buildPdbFile;
+        std::string partition = "6-6-3";
+        std::string searchName = "ida";
+        std::string batchFile;
+        unsigned threads = 0;
+        unsigned jobs = 0;
+        std::vector<int> tiles;
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string arg = argv[i];
+            if (arg.rfind("--pdb=", 0) == 0)
+                pdbFile = arg.substr(6);
+            else if (arg.rfind("--build-pdb=", 0) == 0)
+                buildPdbFile = arg.substr(12);
+            else if (arg.rfind("--partition=", 0) == 0)
+                partition = arg.substr(12);
+            else if (arg.rfind("--search=", 0) == 0)
+                searchName = arg.substr(9);
+            else if (arg.rfind("--threads=", 0) == 0)
+                threads = static_cast<unsigned>(std::atoi(arg.c_str() + 10));
+            else if (arg.rfind("--batch=", 0) == 0)
+                batchFile = arg.substr(8);
+            else if (arg.rfind("--jobs=", 0) == 0)
+                jobs = static_cast<unsigned>(std::atoi(arg.c_str() + 7));
+            else if (arg.rfind("--", 0) == 0)
+                throw std::runtime_error("Unknown option " + arg);
+            else
+                tiles.push_back(std::atoi(arg.c_str()));
+        }
+
+        if (!buildPdbFile.empty())
+        {
+            const auto t0 = steady_clock::now();
+            Pdb::Save(buildPdbFile, Pdb::Partition(partition), FState());
+            std::cout << "Pattern databases " << partition << " built in "
+                      << Ms(steady_clock::now() - t0).count() << " ms" << std::endl;
+            return 0;
+        }
+
+        std::unique_ptr<PatternDatabase> pdb;
+        if (!pdbFile.empty())
+        {
+            const auto t0 = steady_clock::now();
+            pdb = std::make_unique<PatternDatabase>(pdbFile, FState());
+            std::cout << "Pattern databases loaded in " << Ms(steady_clock::now() - t0).count() << " ms" << std::endl;
+        }
+        // calls f(name, search) with the search chosen, for the board of start
+        const auto withSearch = [&](const std::string& name, const auto& start, auto f)
+        {
+            using State = std::decay_t<decltype(start)>;
+            const State goal;
+            if constexpr (std::is_same_v<State, FState>)
+            {
+                if (name == "ida" && pdb)
+                {
+                    IDAStar<FState, std::reference_wrapper<const PatternDatabase>> search(start, goal, std::cref(*pdb));
+                    return f("IDA* (pattern databases)", search);
+                }
+            }
+            else if (pdb)
+                throw std::runtime_error("The pattern databases are for the 4x4 board");
+            if (name == "ida")
+            {
+                IDAStar<State> search(start, goal);
+                return f("IDA*", search);
+            }
+            if (name == "bfs")
+            {
+                BreadthFirst<State> search(start, goal);
+                return f("Breadth first", search);
+            }
+            if (name == "bidirectional")
+            {
+                BidirectionalBreadthFirst<State> search(start, goal);
+                return f("Bidirectional breadth first", search);
+            }
+            if (name == "parallel")
+            {
+                ParallelBreadthFirst<State> search(start, goal, threads);
+                return f("Parallel breadth first", search);
+            }
+            throw std::runtime_error("Unknown search " + name);
+        };
+        const auto runSearch = [&](const std::string& name, const auto& start)
+        {
+            return withSearch(name, start, [](const char* label, auto& search) { return Run(label, search); });
+        };
+        // calls f with a state of the board of cells positions
+        const auto withBoard = [](std::size_t cells, auto f)
+        {
+            switch (cells)
+            {
+            case 9: return f(EightState());
+            case 16: return f(FState());
+            case 25: return f(TwentyFourState());
+            }
+            throw std::runtime_error("Expecting 9, 16 or 25 tiles");
+        };
+
+        if (!batchFile.empty())
+        {
+            const auto lines = ReadInstances(batchFile);
+            if (jobs == 0)
+                jobs = std::max(1u, std::thread::hardware_concurrency());
+            std::cout << lines.size() << " instances, search " << searchName
+                      << (pdb && searchName == "ida" ? " with the pattern databases" : "") << std::endl;
+            return withBoard(lines.empty() ? 16 : lines[0].tiles.size(), [&](auto board)
+            {
+                using State = decltype(board);
+                std::vector<State> instances;
+                std::vector<int> numbers;
+                for (const auto& line: lines)
+                {
+                    instances.push_back(MakeState<State>(line.tiles));
+                    numbers.push_back(line.number);
+                }
+                const auto solve = [&](const State& start)
+                {
+                    return withSearch(searchName, start, [](const char*, auto& search) { return Measure(search); });
+                };
+                return RunBatch(instances, numbers, jobs, solve) ? 0 : 1;
+            });
+        }
+
+        if (!tiles.empty())
+        {
+            std::vector<bool> seen(tiles.size(), false);
+            for (auto tile: tiles)
+                if (tile >= 0 && static_cast<std::size_t>(tile) < tiles.size())
+                    seen[tile] = true;
+            if (std::find(seen.begin(), seen.end(), false) != seen.end())
+                throw std::runtime_error("Expecting the tiles 0-" + std::to_string(tiles.size() - 1));
+            return withBoard(tiles.size(), [&](auto board)
+            {
+                const auto start = MakeState<decltype(board)>(tiles);
+                if (!start.Solvable())
+                    throw std::runtime_error("The start can't reach the goal");
+                return runSearch(searchName, start) ? 0 : 1;
+            });
+        }
+
+        //const FState start( std::array<int, 16>({1,12,6,4,9,7,11,10,15,3,2,13,5,8,14,0}) );
+        const FState start( std::array<int, 16>({2,3,7,4,1,0,11,8,5,6,10,12,9,13,14,15}) );
+        for (auto name: { "bfs", "bidirectional", "parallel", "ida" })
+            runSearch(name, start);
+        return 0;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Exception:\n" << e.what() << std::endl;
+    }
+    return 1;
+}
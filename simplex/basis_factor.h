@@ -0,0 +1,334 @@
+/*******************************************************************************
+ * SIMPLEX - A simplex algorithm implementation.
+ * Copyright (C) 2013 Daniele Pallastrelli
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+#ifndef BASIS_FACTOR_H_
+#define BASIS_FACTOR_H_
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+#include <cassert>
+#include "sparse_matrix.h"
+
+/*
+LU factorization of the basis B (the columns basis[ 0 ] ... basis[ m - 1 ] of A)
+with product form updates.
+
+Factorize computes P B Q = L U column by column (left looking, Gilbert-Peierls):
+at step k the k-th column of the order is solved with the L found so far,
+visiting only the columns of L reachable from its nonzeros, and the pivot is
+chosen among the rows not pivoted yet, with threshold partial pivoting
+preferring the sparsest rows. The columns are taken sparsest first, so the
+slack columns cost nothing.
+
+When a column of the basis is replaced, Update appends an eta matrix
+(product form), and FTRAN/BTRAN apply them after/before the LU solves.
+The etas make the solves slower and less accurate at each update: the caller
+refactorizes when NeedsRefactor() (after RefactorPeriod() updates, or when
+the etas have twice the nonzeros of L and U).
+*/
+template < typename T >
+class BasisFactor
+{
+public:
+    BasisFactor() : m( 0 ), refactor_period( 100 ), eta_nonzeros( 0 ) {}
+
+    size_t RefactorPeriod() const { return refactor_period; }
+    void SetRefactorPeriod( size_t period ) { refactor_period = std::max< size_t >( period, 1 ); }
+    size_t Updates() const { return eta_position.size(); }
+    size_t NonZeros() const { return l_value.size() + u_value.size() + m; }
+    bool NeedsRefactor() const
+    {
+        return Updates() >= refactor_period || eta_nonzeros > 2 * NonZeros();
+    }
+
+    // returns false if the basis is (numerically) singular
+    bool Factorize( const SparseMatrix< T >& a, const std::vector< size_t >& basis )
+    {
+        m = a.Rows();
+        assert( basis.size() == m );
+        Clear();
+
+        // rows with fewer nonzeros are better pivots
+        std::vector< size_t > row_count( m, 0 );
+        for ( size_t p = 0; p < m; ++p )
+            for ( size_t k = a.ColumnBegin( basis[ p ] ); k < a.ColumnEnd( basis[ p ] ); ++k )
+                ++row_count[ a.RowIndex( k ) ];
+
+        std::vector< size_t > order( m );
+        for ( size_t p = 0; p < m; ++p ) order[ p ] = p;
+        std::stable_sort( order.begin(), order.end(), [&]( size_t x, size_t y )
+        {
+            return a.ColumnCount( basis[ x ] ) < a.ColumnCount( basis[ y ] );
+        } );
+
+        std::vector< T > x( m, 0 );
+        std::vector< char > touched( m, 0 );
+        std::vector< size_t > nonzero_rows; // the rows of x that may be nonzero
+        std::vector< size_t > reach;        // the steps to apply, in topological order
+        for ( size_t step = 0; step < m; ++step )
+        {
+            const size_t col = basis[ order[ step ] ];
+            nonzero_rows.clear();
+            for ( size_t k = a.ColumnBegin( col ); k < a.ColumnEnd( col ); ++k )
+            {
+                const size_t r = a.RowIndex( k );
+                x[ r ] = a.Value( k );
+                touched[ r ] = 1;
+                nonzero_rows.push_back( r );
+            }
+            Reach( nonzero_rows, reach );
+            for ( size_t i = reach.size(); i-- > 0; )
+            {
+                const size_t s = reach[ i ];
+                const T xs = x[ pivot_row[ s ] ];
+                if ( xs == 0 ) continue;
+                for ( size_t k = l_start[ s ]; k < l_start[ s + 1 ]; ++k )
+                {
+                    const size_t r = l_row[ k ];
+                    if ( !touched[ r ] )
+                    {
+                        touched[ r ] = 1;
+                        nonzero_rows.push_back( r );
+                    }
+                    x[ r ] -= l_value[ k ] * xs;
+                }
+            }
+
+            // the pivot: the sparsest row among the not pivoted ones with |x| >= 0.1 max |x|
+            T largest = 0;
+            for ( size_t r : nonzero_rows )
+                if ( step_of_row[ r ] == none )
+                    largest = std::max( largest, std::abs( x[ r ] ) );
+            size_t pivot = none;
+            if ( largest > singular_tolerance )
+            {
+                for ( size_t r : nonzero_rows )
+                {
+                    if ( step_of_row[ r ] != none || std::abs( x[ r ] ) < 0.1 * largest ) continue;
+                    if ( pivot == none || row_count[ r ] < row_count[ pivot ] ||
+                         ( row_count[ r ] == row_count[ pivot ] && std::abs( x[ r ] ) > std::abs( x[ pivot ] ) ) )
+                        pivot = r;
+                }
+            }
+            if ( pivot == none )
+            {
+                for ( size_t r : nonzero_rows ) { x[ r ] = 0; touched[ r ] = 0; }
+                return false;
+            }
+
+            // U: the pivoted rows, L: the others divided by the pivot
+            const T diag = x[ pivot ];
+            for ( size_t r : nonzero_rows )
+            {
+                if ( r != pivot && x[ r ] != 0 )
+                {
+                    if ( step_of_row[ r ] != none )
+                    {
+                        u_step.push_back( step_of_row[ r ] );
+                        u_value.push_back( x[ r ] );
+                    }
+                    else
+                    {
+                        l_row.push_back( r );
+                        l_value.push_back( x[ r ] / diag );
+                    }
+                }
+                x[ r ] = 0;
+                touched[ r ] = 0;
+            }
+            u_start.push_back( u_value.size() );
+            l_start.push_back( l_value.size() );
+            u_diag.push_back( diag );
+            pivot_row.push_back( pivot );
+            position.push_back( order[ step ] );
+            step_of_row[ pivot ] = step;
+        }
+        return true;
+    }
+
+    // B z = x: x is indexed by row, and is replaced by z, indexed by basis position
+    void Ftran( std::vector< T >& x ) const
+    {
+        assert( x.size() == m );
+        for ( size_t s = 0; s < m; ++s )
+        {
+            const T xs = x[ pivot_row[ s ] ];
+            if ( xs == 0 ) continue;
+            for ( size_t k = l_start[ s ]; k < l_start[ s + 1 ]; ++k )
+                x[ l_row[ k ] ] -= l_value[ k ] * xs;
+        }
+        work.resize( m );
+        for ( size_t s = m; s-- > 0; )
+        {
+            const T zs = x[ pivot_row[ s ] ] / u_diag[ s ];
+            work[ position[ s ] ] = zs;
+            if ( zs == 0 ) continue;
+            for ( size_t k = u_start[ s ]; k < u_start[ s + 1 ]; ++k )
+                x[ pivot_row[ u_step[ k ] ] ] -= u_value[ k ] * zs;
+        }
+        x.swap( work );
+        for ( size_t e = 0; e < eta_position.size(); ++e )
+        {
+            const size_t r = eta_position[ e ];
+            const T xr = x[ r ] / eta_pivot[ e ];
+            x[ r ] = xr;
+            if ( xr == 0 ) continue;
+            for ( size_t k = eta_start[ e ]; k < eta_start[ e + 1 ]; ++k )
+                x[ eta_index[ k ] ] -= eta_value[ k ] * xr;
+        }
+    }
+
+    // z B = c: c is indexed by basis position, and is replaced by z, indexed by row
+    void Btran( std::vector< T >& c ) const
+    {
+        assert( c.size() == m );
+        for ( size_t e = eta_position.size(); e-- > 0; )
+        {
+            T sum = c[ eta_position[ e ] ];
+            for ( size_t k = eta_start[ e ]; k < eta_start[ e + 1 ]; ++k )
+                sum -= eta_value[ k ] * c[ eta_index[ k ] ];
+            c[ eta_position[ e ] ] = sum / eta_pivot[ e ];
+        }
+        work.resize( m );
+        for ( size_t s = 0; s < m; ++s ) // U^T, work indexed by step
+        {
+            T sum = c[ position[ s ] ];
+            for ( size_t k = u_start[ s ]; k < u_start[ s + 1 ]; ++k )
+                sum -= u_value[ k ] * work[ u_step[ k ] ];
+            work[ s ] = sum / u_diag[ s ];
+        }
+        for ( size_t s = m; s-- > 0; ) // L^T, c indexed by row
+        {
+            T sum = work[ s ];
+            for ( size_t k = l_start[ s ]; k < l_start[ s + 1 ]; ++k )
+                sum -= l_value[ k ] * c[ l_row[ k ] ];
+            c[ pivot_row[ s ] ] = sum;
+        }
+    }
+
+    // the column in basis position r is replaced by the one whose FTRAN is alpha
+    void Update( size_t r, const std::vector< T >& alpha )
+    {
+        assert( r < m && alpha[ r ] != 0 );
+        for ( size_t i = 0; i < m; ++i )
+        {
+            if ( i != r && alpha[ i ] != 0 )
+            {
+                eta_index.push_back( i );
+                eta_value.push_back( alpha[ i ] );
+            }
+        }
+        eta_start.push_back( eta_value.size() );
+        eta_position.push_back( r );
+        eta_pivot.push_back( alpha[ r ] );
+        eta_nonzeros = eta_value.size();
+    }
+private:
+    static constexpr size_t none = std::numeric_limits< size_t >::max();
+    static constexpr double singular_tolerance = 1e-11;
+
+    void Clear()
+    {
+        l_start.assign( 1, 0 ); l_row.clear(); l_value.clear();
+        u_start.assign( 1, 0 ); u_step.clear(); u_value.clear(); u_diag.clear();
+        pivot_row.clear(); position.clear();
+        step_of_row.assign( m, none );
+        visited.assign( m, 0 );
+        eta_start.assign( 1, 0 ); eta_index.clear(); eta_value.clear();
+        eta_position.clear(); eta_pivot.clear();
+        eta_nonzeros = 0;
+    }
+    // the steps of L reachable from the pivoted rows in rows,
+    // in reverse topological order (depth first postorder)
+    void Reach( const std::vector< size_t >& rows, std::vector< size_t >& reach )
+    {
+        reach.clear();
+        for ( size_t r : rows )
+        {
+            const size_t start = step_of_row[ r ];
+            if ( start == none || visited[ start ] ) continue;
+            dfs_stack.clear();
+            dfs_stack.push_back( std::make_pair( start, l_start[ start ] ) );
+            visited[ start ] = 1;
+            while ( !dfs_stack.empty() )
+            {
+                const size_t s = dfs_stack.back().first;
+                size_t& k = dfs_stack.back().second;
+                for ( ; k < l_start[ s + 1 ]; ++k )
+                {
+                    const size_t next = step_of_row[ l_row[ k ] ];
+                    if ( next != none && !visited[ next ] )
+                        break;
+                }
+                if ( k < l_start[ s + 1 ] )
+                {
+                    const size_t next = step_of_row[ l_row[ k ] ];
+                    visited[ next ] = 1;
+                    dfs_stack.push_back( std::make_pair( next, l_start[ next ] ) );
+                }
+                else
+                {
+                    reach.push_back( s );
+                    dfs_stack.pop_back();
+                }
+            }
+        }
+        for ( size_t s : reach ) visited[ s ] = 0;
+    }
+
+    size_t m;
+    size_t refactor_period;
+
+    // L: unit lower triangular, column s holds the multipliers of the rows below pivot_row[ s ]
+    std::vector< size_t > l_start, l_row;
+    std::vector< T > l_value;
+    // U: column s holds the entries of the steps before s, and u_diag[ s ]
+    std::vector< size_t > u_start, u_step;
+    std::vector< T > u_value, u_diag;
+    std::vector< size_t > pivot_row;   // by step
+    std::vector< size_t > position;    // basis position factored at each step
+    std::vector< size_t > step_of_row; // none if not pivoted yet
+
+    // product form etas: eta e replaces basis position eta_position[ e ]
+    std::vector< size_t > eta_start, eta_index, eta_position;
+    std::vector< T > eta_value, eta_pivot;
+    size_t eta_nonzeros;
+
+    mutable std::vector< T > work;
+    std::vector< char > visited;
+    std::vector< std::pair< size_t, size_t > > dfs_stack;
+};
+
+template < typename T > constexpr size_t BasisFactor< T >::none;
+template < typename T > constexpr double BasisFactor< T >::singular_tolerance;
+
+#endif // BASIS_FACTOR_H_
@@ -0,0 +1,166 @@
+/*******************************************************************************
+ * SIMPLEX - A simplex algorithm implementation.
+ * Copyright (C) 2013 Daniele Pallastrelli
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+/*
+Microbenchmark of the row kernels of the tableau: the elimination step of
+SimplexTableau::Solve (the pivot row divided by the pivot, then every other
+row += coeff * the pivot row) on tableaux of growing size, with the old
+indexed loop (Value( r, c ) for each cell) and with the kernels of every
+instruction set the cpu supports.
+Checks that the kernels give the same tableau, bit by bit.
+
+bench_kernels [REPEAT]
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include "tableau.h"
+
+using namespace std;
+
+namespace
+{
+    void Fill( Matrix< double >& m )
+    {
+        unsigned x = 12345;
+        for ( size_t r = 0; r < m.Rows(); ++r )
+            for ( size_t c = 0; c < m.Columns(); ++c )
+            {
+                x = x * 1664525u + 1013904223u;
+                m.Value( r, c ) = 1.0 + ( x >> 8 ) % 1000 / 100.0;
+            }
+    }
+
+    // the elimination with the pivots on the diagonal, as SimplexTableau::Solve
+    // before the kernels: through Value, one cell at a time
+    void EliminateIndexed( Matrix< double >& m, size_t pivots )
+    {
+        for ( size_t p = 0; p < pivots; ++p )
+        {
+            const size_t pivRow = p % m.Rows(), pivCol = p % m.Columns();
+            const double d = m.Value( pivRow, pivCol );
+            for ( size_t c = 0; c < m.Columns(); ++c )
+                m.Value( pivRow, c ) /= d;
+            for ( size_t r = 0; r < m.Rows(); ++r )
+            {
+                if ( r == pivRow ) continue;
+                const double coeff = - m.Value( r, pivCol );
+                for ( size_t c = 0; c < m.Columns(); ++c )
+                    m.Value( r, c ) += m.Value( pivRow, c ) * coeff;
+            }
+        }
+    }
+
+    // the same with Matrix::DivideRow and Matrix::Linear
+    void Eliminate( Matrix< double >& m, size_t pivots )
+    {
+        for ( size_t p = 0; p < pivots; ++p )
+        {
+            const size_t pivRow = p % m.Rows(), pivCol = p % m.Columns();
+            m.DivideRow( pivRow, m.Value( pivRow, pivCol ) );
+            for ( size_t r = 0; r < m.Rows(); ++r )
+                if ( r != pivRow )
+                    m.Linear( r, pivRow, - m.Value( r, pivCol ) );
+        }
+    }
+
+    bool Same( const Matrix< double >& a, const Matrix< double >& b )
+    {
+        for ( size_t r = 0; r < a.Rows(); ++r )
+            if ( memcmp( a.Row( r ), b.Row( r ), a.Columns() * sizeof( double ) ) != 0 )
+                return false;
+        return true;
+    }
+
+    template < typename F >
+    double TimeMs( F f )
+    {
+        const auto start = chrono::steady_clock::now();
+        f();
+        return chrono::duration< double, milli >( chrono::steady_clock::now() - start ).count();
+    }
+}
+
+int main( int argc, char* argv[] )
+{
+    const int repeat = argc > 1 ? atoi( argv[ 1 ] ) : 3;
+    const RowKernels::Isa best = RowKernels::Detect();
+    cout << "Best instruction set: " << RowKernels::Name( best ) << endl;
+
+    const size_t sizes[][ 2 ] = { { 16, 32 }, { 64, 128 }, { 256, 512 }, { 1000, 2000 }, { 2000, 4000 }, { 4000, 8000 } };
+    cout << setw( 12 ) << "tableau" << setw( 10 ) << "pivots" << setw( 12 ) << "kernel"
+         << setw( 12 ) << "ms" << setw( 14 ) << "Mcells/s" << setw( 10 ) << "speedup" << endl;
+    bool same = true;
+    for ( const auto& size : sizes )
+    {
+        const size_t rows = size[ 0 ], cols = size[ 1 ];
+        // about 2e8 cells updated per measure
+        const size_t pivots = max< size_t >( 1, 200000000 / ( rows * cols ) );
+
+        Matrix< double > reference( rows, cols );
+        Fill( reference );
+        EliminateIndexed( reference, pivots ); // warm up, and the expected result
+
+        auto measure = [&]( const char* name, bool indexed, double baseline ) -> double
+        {
+            double best_ms = 0;
+            for ( int i = 0; i < repeat; ++i )
+            {
+                Matrix< double > m( rows, cols );
+                Fill( m );
+                const double ms = TimeMs( [&]() { if ( indexed ) EliminateIndexed( m, pivots ); else Eliminate( m, pivots ); } );
+                if ( i == 0 || ms < best_ms ) best_ms = ms;
+                if ( !indexed && !Same( m, reference ) )
+                {
+                    same = false;
+                    cout << "DIFFERENT RESULT with " << name << endl;
+                }
+            }
+            const double cells = double( pivots ) * rows * cols;
+            cout << setw( 5 ) << rows << " x " << setw( 4 ) << cols << setw( 10 ) << pivots << setw( 12 ) << name
+                 << setw( 12 ) << fixed << setprecision( 1 ) << best_ms
+                 << setw( 14 ) << cells / best_ms / 1000
+                 << setw( 9 ) << setprecision( 2 ) << ( baseline > 0 ? baseline / best_ms : 1.0 ) << "x" << endl;
+            return best_ms;
+        };
+        const double indexed = measure( "indexed", true, 0 );
+        for ( int isa = RowKernels::Scalar; isa <= best; ++isa )
+        {
+            RowKernels::Select( static_cast< RowKernels::Isa >( isa ) );
+            measure( RowKernels::Name( static_cast< RowKernels::Isa >( isa ) ), false, indexed );
+        }
+        RowKernels::Select( best );
+    }
+    cout << ( same ? "All the kernels give the same tableaux" : "The kernels give DIFFERENT tableaux" ) << endl;
+    return same ? 0 : 1;
+}
@@ -0,0 +1,163 @@
+/*******************************************************************************
+ * SIMPLEX - A simplex algorithm implementation.
+ * Copyright (C) 2013 Daniele Pallastrelli
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+/*
+Benchmark of the pricing policies of SimplexTableau: the pivots and the time
+of Solve with each Pricing on the Klee-Minty cubes (the worst case of Dantzig's
+rule) and on random problems max c x, A x <= b, x >= 0 dense, sparse and wide
+(many more columns than rows, the case of the partial pricing).
+Checks that all the policies find the same optimum.
+
+bench_pricing [THREADS]
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <random>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include "tableau.h"
+
+using namespace std;
+
+namespace
+{
+    // max c x subject to A x <= b, with b >= 0 (the origin is feasible)
+    struct Problem
+    {
+        string name;
+        size_t rows, columns;
+        vector< double > a; // rows x columns
+        vector< double > b, c;
+        bool kleeMinty = false; // the pivots can be 2^columns
+    };
+
+    // max sum 2^(n-j) x_j, sum_{j<i} 2^(i-j+1) x_j + x_i <= 5^i: the optimum is 5^n,
+    // and Dantzig's rule visits all the 2^n vertices
+    Problem KleeMinty( size_t n )
+    {
+        Problem p{ "Klee-Minty " + to_string( n ), n, n, vector< double >( n * n, 0.0 ), vector< double >( n ), vector< double >( n ) };
+        for ( size_t i = 0; i < n; ++i )
+        {
+            for ( size_t j = 0; j < i; ++j )
+                p.a[ i * n + j ] = ldexp( 1.0, int( i - j + 1 ) );
+            p.a[ i * n + i ] = 1;
+            p.b[ i ] = pow( 5.0, double( i + 1 ) );
+            p.c[ i ] = ldexp( 1.0, int( n - i - 1 ) );
+        }
+        p.kleeMinty = true;
+        return p;
+    }
+
+    // density: the probability of a nonzero in A
+    Problem Random( const string& name, size_t rows, size_t columns, double density, unsigned seed )
+    {
+        Problem p{ name, rows, columns, vector< double >( rows * columns, 0.0 ), vector< double >( rows ), vector< double >( columns ) };
+        mt19937 rng( seed );
+        uniform_real_distribution< double > value( 1, 10 ), u( 0, 1 );
+        for ( size_t j = 0; j < columns; ++j )
+        {
+            p.c[ j ] = value( rng );
+            // at least one entry for each column, so the problem is bounded
+            p.a[ ( rng() % rows ) * columns + j ] = value( rng );
+        }
+        for ( size_t i = 0; i < rows; ++i )
+        {
+            for ( size_t j = 0; j < columns; ++j )
+                if ( u( rng ) < density ) p.a[ i * columns + j ] = value( rng );
+            p.b[ i ] = 100 * value( rng );
+        }
+        return p;
+    }
+
+    // the tableau of p: Z, the variables, the slacks, b
+    void Fill( const Problem& p, SimplexTableau< double >& st )
+    {
+        const size_t cols = st.Columns();
+        vector< double > row( cols, 0.0 );
+        row[ 0 ] = 1;
+        copy( p.c.begin(), p.c.end(), row.begin() + 1 );
+        st.SetRow( 0, &row[ 0 ] );
+        for ( size_t i = 0; i < p.rows; ++i )
+        {
+            fill( row.begin(), row.end(), 0.0 );
+            copy( p.a.begin() + i * p.columns, p.a.begin() + ( i + 1 ) * p.columns, row.begin() + 1 );
+            row[ 1 + p.columns + i ] = 1;
+            row[ cols - 1 ] = p.b[ i ];
+            st.SetRow( i + 1, &row[ 0 ] );
+        }
+    }
+}
+
+int main( int argc, char* argv[] )
+{
+    const size_t threads = argc > 1 ? atoi( argv[ 1 ] ) : 1;
+    const Pricing policies[] = { Pricing::FirstFit, Pricing::Dantzig, Pricing::Devex,
+                                 Pricing::SteepestEdge, Pricing::Partial, Pricing::Multiple };
+    vector< Problem > problems;
+    problems.push_back( KleeMinty( 8 ) );
+    problems.push_back( KleeMinty( 12 ) );
+    problems.push_back( Random( "dense", 200, 300, 1.0, 1 ) );
+    problems.push_back( Random( "sparse", 400, 800, 0.05, 2 ) );
+    problems.push_back( Random( "wide", 50, 20000, 0.2, 3 ) );
+
+    bool same = true;
+    for ( const Problem& p : problems )
+    {
+        const size_t cols = 1 + p.columns + p.rows + 1;
+        cout << p.name << ": " << p.rows + 1 << " x " << cols << " tableau" << endl;
+        double optimum = 0;
+        for ( Pricing policy : policies )
+        {
+            SimplexTableau< double > st( p.rows + 1, cols );
+            Fill( p, st );
+            st.SetVerbose( false );
+            st.SetThreads( threads );
+            st.SetPricing( policy );
+            size_t maxIter = 100 * ( p.rows + p.columns );
+            if ( p.kleeMinty && p.columns < 63 ) maxIter = max( maxIter, size_t( 1 ) << ( p.columns + 1 ) );
+            const auto start = chrono::steady_clock::now();
+            st.Solve( maxIter );
+            const chrono::duration< double, milli > elapsed = chrono::steady_clock::now() - start;
+            const double z = - st.Value( 0, cols - 1 );
+            if ( policy == policies[ 0 ] ) optimum = z;
+            const bool ok = fabs( z - optimum ) <= 1e-6 * max( 1.0, fabs( optimum ) );
+            same = same && ok;
+            cout << setw( 16 ) << PricingName( policy ) << setw( 10 ) << st.Iterations() << " pivots"
+                 << setw( 12 ) << fixed << setprecision( 1 ) << elapsed.count() << " ms"
+                 << "   Z = " << setprecision( 6 ) << z << ( ok ? "" : "  DIFFERENT OPTIMUM" ) << endl;
+        }
+        cout << endl;
+    }
+    cout << ( same ? "All the policies find the same optimum" : "The policies find DIFFERENT optima" ) << endl;
+    return same ? 0 : 1;
+}
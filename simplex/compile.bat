@@ -1 +1,3 @@
 cl /EHa main.cpp /Fesimplex
+cl /EHa /O2 bench_kernels.cpp /Febench_kernels
+cl /EHa /O2 bench_pricing.cpp /Febench_pricing
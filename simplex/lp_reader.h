@@ -0,0 +1,742 @@
+/*******************************************************************************
+ * SIMPLEX - A simplex algorithm implementation.
+ * Copyright (C) 2013 Daniele Pallastrelli
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+#ifndef LP_READER_H_
+#define LP_READER_H_
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <functional>
+#include <fstream>
+#include <stdexcept>
+#include <limits>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+#include <cassert>
+#include "sparse_matrix.h"
+
+/*
+Readers of the free MPS and of the CPLEX LP files, for RevisedSimplex:
+the problem of the file becomes
+Minimize
+    c x + offset
+Subject to
+    A x = b, x >= 0
+with a slack column (+1) for each <= row and a surplus column (-1) for each >= row.
+
+The files are read a line at a time. The columns of a MPS file come one after
+the other, so they go straight into the SparseMatrix; the rows of a LP file
+are kept as their nonzeros (row, column, value) until the end, then sorted by
+column. Either way the memory grows with the nonzeros, never with rows * columns.
+
+The bounds other than x >= 0 are changed into the same form:
+    x >= l           x = l + x', only b and the offset change
+    x <= u           a new row x' + s = u - l
+    free             x = x' - x'', a new column -A_j
+The bound x <= u of a variable without the lower bound is not supported,
+nor the RANGES of the MPS files; the integer variables get their LP relaxation.
+*/
+template < typename T >
+struct LinearProgram
+{
+    SparseMatrix< T > a;
+    std::vector< T > b, c;
+    T offset = 0;
+    bool maximize = false; // the file maximizes: c and offset are the opposite ones
+    size_t structurals = 0; // the columns of the file, the first ones of a
+    size_t slacks = 0;      // the slack and surplus columns, the last ones of a
+    std::vector< std::string > rowNames, columnNames; // the rows and the columns of the file
+    std::vector< T > lower;          // of the columns of the file
+    std::vector< size_t > negative;  // the column x'' of the free columns, none for the others
+
+    static constexpr size_t none = std::numeric_limits< size_t >::max();
+
+    // the objective of the file, from c x of a solution
+    T Objective( T cx ) const { return maximize ? - ( cx + offset ) : cx + offset; }
+    // the values of the columns of the file, from the solution x of a
+    std::vector< T > Solution( const std::vector< T >& x ) const
+    {
+        std::vector< T > values( structurals );
+        for ( size_t j = 0; j < structurals; ++j )
+            values[ j ] = lower[ j ] + x[ j ] - ( negative[ j ] == none ? T( 0 ) : x[ negative[ j ] ] );
+        return values;
+    }
+};
+
+template < typename T >
+constexpr size_t LinearProgram< T >::none;
+
+namespace LpReader
+{
+    enum RowType { Less, Greater, Equal };
+
+    inline std::runtime_error Error( const std::string& fileName, size_t line, const std::string& message )
+    {
+        return std::runtime_error( fileName + ":" + std::to_string( line ) + ": " + message );
+    }
+
+    inline bool SameText( const std::string& s, const char* keyword )
+    {
+        if ( s.size() != std::strlen( keyword ) ) return false;
+        for ( size_t i = 0; i < s.size(); ++i )
+            if ( std::tolower( static_cast< unsigned char >( s[ i ] ) ) != keyword[ i ] ) return false;
+        return true;
+    }
+
+    // the number of s, false if s isn't all a number (infinity and inf included)
+    template < typename T >
+    bool ToNumber( const std::string& s, T& value )
+    {
+        if ( SameText( s, "infinity" ) || SameText( s, "inf" ) || SameText( s, "+infinity" ) || SameText( s, "+inf" ) )
+        {
+            value = std::numeric_limits< T >::infinity();
+            return true;
+        }
+        if ( SameText( s, "-infinity" ) || SameText( s, "-inf" ) )
+        {
+            value = - std::numeric_limits< T >::infinity();
+            return true;
+        }
+        char* end = nullptr;
+        value = static_cast< T >( std::strtod( s.c_str(), &end ) );
+        return !s.empty() && end == s.c_str() + s.size();
+    }
+
+    // the bounds of the columns and the types of the rows, until the problem is complete
+    template < typename T >
+    class Builder
+    {
+    public:
+        explicit Builder( LinearProgram< T >& _lp ) : lp( _lp ) {}
+
+        // the index of a new row
+        size_t AddRow( const std::string& name, RowType type )
+        {
+            lp.rowNames.push_back( name );
+            rowTypes.push_back( type );
+            lp.b.push_back( 0 );
+            return rowTypes.size() - 1;
+        }
+        // the index of a new column of the file
+        size_t AddColumn( const std::string& name )
+        {
+            lp.columnNames.push_back( name );
+            lp.c.push_back( 0 );
+            lower.push_back( 0 );
+            upper.push_back( std::numeric_limits< T >::infinity() );
+            return lp.columnNames.size() - 1;
+        }
+        size_t Rows() const { return rowTypes.size(); }
+        T& Lower( size_t j ) { return lower[ j ]; }
+        T& Upper( size_t j ) { return upper[ j ]; }
+
+        // the columns of the file are all in lp.a: the bounds and the slack columns.
+        // Returns false for a bound that isn't supported, with the column in j
+        bool Finish( size_t& j )
+        {
+            const T inf = std::numeric_limits< T >::infinity();
+            SparseMatrix< T >& a = lp.a;
+            const size_t m = Rows(), n = a.Columns();
+            assert( n == lp.columnNames.size() );
+            lp.structurals = n;
+            lp.negative.assign( n, LinearProgram< T >::none );
+            size_t bounded = 0, free = 0;
+            for ( j = 0; j < n; ++j )
+            {
+                if ( lower[ j ] == -inf && upper[ j ] != inf ) return false;
+                if ( lower[ j ] == -inf ) { lower[ j ] = 0; ++free; lp.negative[ j ] = 0; continue; }
+                if ( upper[ j ] != inf ) ++bounded;
+                if ( lower[ j ] == 0 ) continue;
+                // x = l + x'
+                for ( size_t k = a.ColumnBegin( j ); k < a.ColumnEnd( j ); ++k )
+                    lp.b[ a.RowIndex( k ) ] -= a.Value( k ) * lower[ j ];
+                lp.offset += lp.c[ j ] * lower[ j ];
+            }
+            if ( bounded > 0 || free > 0 )
+            {
+                // the matrix again, with the rows of the upper bounds and the columns x''
+                SparseMatrix< T > full( m + bounded );
+                full.Reserve( n + free + m + bounded, a.NonZeros() * ( free > 0 ? 2 : 1 ) + 2 * bounded );
+                for ( j = 0; j < n; ++j )
+                {
+                    for ( size_t k = a.ColumnBegin( j ); k < a.ColumnEnd( j ); ++k )
+                        full.AddEntry( a.RowIndex( k ), a.Value( k ) );
+                    if ( upper[ j ] != inf )
+                    {
+                        full.AddEntry( AddRow( lp.columnNames[ j ] + "_upper", Less ), 1 );
+                        lp.b.back() = upper[ j ] - lower[ j ];
+                    }
+                    full.EndColumn();
+                }
+                for ( j = 0; j < n; ++j )
+                {
+                    if ( lp.negative[ j ] == LinearProgram< T >::none ) continue;
+                    for ( size_t k = a.ColumnBegin( j ); k < a.ColumnEnd( j ); ++k )
+                        full.AddEntry( a.RowIndex( k ), - a.Value( k ) );
+                    lp.negative[ j ] = full.EndColumn();
+                    lp.c.push_back( - lp.c[ j ] );
+                }
+                a = std::move( full );
+            }
+            // the slack and surplus columns
+            for ( size_t i = 0; i < Rows(); ++i )
+            {
+                if ( rowTypes[ i ] == Equal ) continue;
+                a.AddEntry( i, rowTypes[ i ] == Less ? 1 : -1 );
+                a.EndColumn();
+                lp.c.push_back( 0 );
+                ++lp.slacks;
+            }
+            if ( lp.maximize )
+            {
+                for ( T& cj : lp.c ) cj = - cj;
+                lp.offset = - lp.offset;
+            }
+            lp.lower.swap( lower );
+            return true;
+        }
+    private:
+        LinearProgram< T >& lp;
+        std::vector< RowType > rowTypes;
+        std::vector< T > lower, upper;
+    };
+
+    // the fields of a line separated by blanks, in the strings of fields (reused)
+    inline size_t Split( const std::string& line, std::vector< std::string >& fields )
+    {
+        size_t count = 0;
+        for ( size_t i = 0; i < line.size(); )
+        {
+            while ( i < line.size() && std::isspace( static_cast< unsigned char >( line[ i ] ) ) ) ++i;
+            if ( i == line.size() ) break;
+            const size_t start = i;
+            while ( i < line.size() && !std::isspace( static_cast< unsigned char >( line[ i ] ) ) ) ++i;
+            if ( fields.size() == count ) fields.emplace_back();
+            fields[ count++ ].assign( line, start, i - start );
+        }
+        return count;
+    }
+}
+
+// reads the free MPS file of in (fileName for the errors)
+template < typename T >
+LinearProgram< T > ReadMps( std::istream& in, const std::string& fileName )
+{
+    using namespace LpReader;
+    enum Section { Start, Name, ObjSense, Rows, Columns, Rhs, Ranges, Bounds, End };
+    const size_t objective = std::numeric_limits< size_t >::max(), ignored = objective - 1;
+
+    LinearProgram< T > lp;
+    Builder< T > builder( lp );
+    std::unordered_map< std::string, size_t > rows, columns;
+    bool hasObjective = false;
+    Section section = Start;
+    std::string line;
+    std::vector< std::string > fields;
+    size_t current = LinearProgram< T >::none; // the column being read
+    size_t lineNumber = 0;
+
+    auto row = [&]( const std::string& name ) -> size_t
+    {
+        const auto i = rows.find( name );
+        if ( i == rows.end() ) throw Error( fileName, lineNumber, "unknown row " + name );
+        return i->second;
+    };
+    auto number = [&]( const std::string& s ) -> T
+    {
+        T value;
+        if ( !ToNumber( s, value ) ) throw Error( fileName, lineNumber, "expecting a number instead of " + s );
+        return value;
+    };
+
+    while ( section != End && std::getline( in, line ) )
+    {
+        ++lineNumber;
+        const size_t count = Split( line, fields );
+        if ( count == 0 || line[ 0 ] == '*' ) continue;
+        if ( !std::isspace( static_cast< unsigned char >( line[ 0 ] ) ) )
+        {
+            const std::string& s = fields[ 0 ];
+            const Section next = s == "NAME" ? Name : s == "OBJSENSE" ? ObjSense : s == "ROWS" ? Rows :
+                                 s == "COLUMNS" ? Columns : s == "RHS" ? Rhs : s == "RANGES" ? Ranges :
+                                 s == "BOUNDS" ? Bounds : s == "ENDATA" ? End : Start;
+            if ( next == Start ) throw Error( fileName, lineNumber, "unknown section " + s );
+            if ( next == Ranges ) throw Error( fileName, lineNumber, "RANGES are not supported" );
+            if ( section == Columns && current != LinearProgram< T >::none )
+                lp.a.EndColumn();
+            if ( next == Columns )
+                lp.a = SparseMatrix< T >( builder.Rows() );
+            section = next;
+            if ( section == ObjSense && count > 1 ) lp.maximize = SameText( fields[ 1 ], "max" ) || SameText( fields[ 1 ], "maximize" );
+            continue;
+        }
+        switch ( section )
+        {
+            case ObjSense:
+                lp.maximize = SameText( fields[ 0 ], "max" ) || SameText( fields[ 0 ], "maximize" );
+                break;
+            case Rows:
+            {
+                if ( count != 2 ) throw Error( fileName, lineNumber, "expecting the type and the name of the row" );
+                const std::string& type = fields[ 0 ];
+                size_t index;
+                if ( type == "N" )
+                {
+                    index = hasObjective ? ignored : objective;
+                    hasObjective = true;
+                }
+                else if ( type == "L" || type == "G" || type == "E" )
+                    index = builder.AddRow( fields[ 1 ], type == "L" ? Less : type == "G" ? Greater : Equal );
+                else
+                    throw Error( fileName, lineNumber, "unknown row type " + type );
+                if ( !rows.insert( std::make_pair( fields[ 1 ], index ) ).second )
+                    throw Error( fileName, lineNumber, "row " + fields[ 1 ] + " defined twice" );
+                break;
+            }
+            case Columns:
+            {
+                if ( count >= 2 && fields[ 1 ] == "'MARKER'" ) break; // the integer columns: their relaxation
+                if ( count != 3 && count != 5 ) throw Error( fileName, lineNumber, "expecting column row value [row value]" );
+                if ( current == LinearProgram< T >::none || fields[ 0 ] != lp.columnNames[ current ] )
+                {
+                    if ( current != LinearProgram< T >::none ) lp.a.EndColumn();
+                    current = builder.AddColumn( fields[ 0 ] );
+                    if ( !columns.insert( std::make_pair( fields[ 0 ], current ) ).second )
+                        throw Error( fileName, lineNumber, "the entries of column " + fields[ 0 ] + " are not together" );
+                }
+                for ( size_t f = 1; f < count; f += 2 )
+                {
+                    const size_t r = row( fields[ f ] );
+                    const T value = number( fields[ f + 1 ] );
+                    if ( r == objective ) lp.c[ current ] += value;
+                    else if ( r != ignored ) lp.a.AddEntry( r, value );
+                }
+                break;
+            }
+            case Rhs:
+            {
+                // the name of the right hand side can be missing
+                for ( size_t f = count % 2; f + 1 < count; f += 2 )
+                {
+                    const size_t r = row( fields[ f ] );
+                    const T value = number( fields[ f + 1 ] );
+                    if ( r == objective ) lp.offset = - value;
+                    else if ( r != ignored ) lp.b[ r ] = value;
+                }
+                break;
+            }
+            case Bounds:
+            {
+                const std::string& type = fields[ 0 ];
+                // BV can have the value 1 or not
+                const bool valued = type == "BV" ? columns.count( fields[ count - 1 ] ) == 0 :
+                                    !( type == "FR" || type == "MI" || type == "PL" );
+                // the name of the bound can be missing
+                const size_t f = count - ( valued ? 2 : 1 );
+                if ( f < 1 || f > 2 ) throw Error( fileName, lineNumber, "expecting type [bound] column [value]" );
+                const auto column = columns.find( fields[ f ] );
+                if ( column == columns.end() ) throw Error( fileName, lineNumber, "unknown column " + fields[ f ] );
+                const size_t j = column->second;
+                const T value = valued ? number( fields[ f + 1 ] ) : T( 0 );
+                const T inf = std::numeric_limits< T >::infinity();
+                if ( type == "LO" ) builder.Lower( j ) = value;
+                else if ( type == "UP" ) builder.Upper( j ) = value;
+                else if ( type == "FX" ) builder.Lower( j ) = builder.Upper( j ) = value;
+                else if ( type == "FR" ) { builder.Lower( j ) = -inf; builder.Upper( j ) = inf; }
+                else if ( type == "MI" ) builder.Lower( j ) = -inf;
+                else if ( type == "PL" ) builder.Upper( j ) = inf;
+                else if ( type == "BV" ) { builder.Lower( j ) = 0; builder.Upper( j ) = 1; }
+                else if ( type == "LI" ) builder.Lower( j ) = value;
+                else if ( type == "UI" ) builder.Upper( j ) = value;
+                else throw Error( fileName, lineNumber, "unknown bound type " + type );
+                break;
+            }
+            default:
+                throw Error( fileName, lineNumber, "data outside of the sections" );
+        }
+    }
+    if ( section != End ) throw Error( fileName, lineNumber, "missing ENDATA" );
+    size_t j;
+    if ( !builder.Finish( j ) )
+        throw std::runtime_error( fileName + ": column " + lp.columnNames[ j ] + ": upper bound without lower bound is not supported" );
+    return lp;
+}
+
+namespace LpReader
+{
+    // the tokens of a CPLEX LP file
+    class Tokenizer
+    {
+    public:
+        enum Kind { Section, Number, Name, Operator, End };
+        enum SectionKind { Maximize, Minimize, SubjectTo, BoundsSection, General, Binary, EndSection };
+        struct Token
+        {
+            Kind kind;
+            std::string text;  // the name, the operator (<=, >=, =, +, -, :)
+            double number;
+            SectionKind section;
+            size_t line;
+        };
+
+        Tokenizer( std::istream& _in, const std::string& _fileName ) : in( _in ), fileName( _fileName ), line( 0 ) {}
+
+        const Token& Peek( size_t k = 0 )
+        {
+            while ( tokens.size() <= k ) Read();
+            return tokens[ k ];
+        }
+        Token Next()
+        {
+            Peek();
+            Token t = std::move( tokens.front() );
+            tokens.pop_front();
+            return t;
+        }
+        std::runtime_error Error( const std::string& message ) { return LpReader::Error( fileName, Peek().line, message ); }
+    private:
+        // the tokens of the next line (the End token at the end of the file)
+        void Read()
+        {
+            std::string text;
+            if ( !std::getline( in, text ) )
+            {
+                tokens.push_back( Token{ End, "", 0, EndSection, line } );
+                return;
+            }
+            ++line;
+            text = text.substr( 0, text.find( '\\' ) );
+            size_t i = 0;
+            auto blank = [&]() { while ( i < text.size() && std::isspace( static_cast< unsigned char >( text[ i ] ) ) ) ++i; };
+            blank();
+            size_t begin = i;
+            SectionKind section;
+            if ( SectionAt( text, i, section ) )
+            {
+                tokens.push_back( Token{ Section, "", 0, section, line } );
+                blank();
+                begin = i;
+            }
+            while ( ( i = begin ) < text.size() )
+            {
+                const char ch = text[ i ];
+                if ( std::strchr( "<>=", ch ) )
+                {
+                    // <=, =<, <, >=, =>, >, =
+                    std::string op( 1, ch );
+                    if ( i + 1 < text.size() && std::strchr( "<>=", text[ i + 1 ] ) ) op += text[ ++i ];
+                    ++i;
+                    if ( op == "<" || op == "=<" ) op = "<=";
+                    else if ( op == ">" || op == "=>" ) op = ">=";
+                    else if ( op != "<=" && op != ">=" && op != "=" ) throw LpReader::Error( fileName, line, "unknown operator " + op );
+                    tokens.push_back( Token{ Operator, op, 0, EndSection, line } );
+                }
+                else if ( ch == '+' || ch == '-' || ch == ':' )
+                {
+                    tokens.push_back( Token{ Operator, std::string( 1, ch ), 0, EndSection, line } );
+                    ++i;
+                }
+                else if ( std::isdigit( static_cast< unsigned char >( ch ) ) || ch == '.' )
+                {
+                    const char* start = text.c_str() + i;
+                    char* end = nullptr;
+                    const double value = std::strtod( start, &end );
+                    if ( end == start ) throw LpReader::Error( fileName, line, "bad number " + text.substr( i ) );
+                    i += end - start;
+                    tokens.push_back( Token{ Number, "", value, EndSection, line } );
+                }
+                else
+                {
+                    while ( i < text.size() && !std::isspace( static_cast< unsigned char >( text[ i ] ) ) && !std::strchr( "<>=+-:", text[ i ] ) ) ++i;
+                    std::string name = text.substr( begin, i - begin );
+                    if ( SameText( name, "inf" ) || SameText( name, "infinity" ) )
+                        tokens.push_back( Token{ Number, "", std::numeric_limits< double >::infinity(), EndSection, line } );
+                    else
+                        tokens.push_back( Token{ Name, std::move( name ), 0, EndSection, line } );
+                }
+                blank();
+                begin = i;
+            }
+        }
+        // the keyword of a section at the position i of the line (then i goes after it)
+        static bool SectionAt( const std::string& text, size_t& i, SectionKind& section )
+        {
+            static const struct { const char* keyword; SectionKind section; } keywords[] =
+            {
+                { "maximize", Maximize }, { "maximise", Maximize }, { "maximum", Maximize }, { "max", Maximize },
+                { "minimize", Minimize }, { "minimise", Minimize }, { "minimum", Minimize }, { "min", Minimize },
+                { "subject to", SubjectTo }, { "such that", SubjectTo }, { "s.t.", SubjectTo }, { "st.", SubjectTo }, { "st", SubjectTo },
+                { "bounds", BoundsSection }, { "bound", BoundsSection },
+                { "generals", General }, { "general", General }, { "gen", General }, { "integers", General },
+                { "binaries", Binary }, { "binary", Binary }, { "bin", Binary },
+                { "end", EndSection }
+            };
+            for ( const auto& k : keywords )
+            {
+                const size_t n = std::strlen( k.keyword );
+                if ( text.size() - i < n ) continue;
+                // the keyword alone on the line, or followed by a blank
+                if ( text.size() - i > n && !std::isspace( static_cast< unsigned char >( text[ i + n ] ) ) ) continue;
+                if ( !SameText( text.substr( i, n ), k.keyword ) ) continue;
+                i += n;
+                section = k.section;
+                return true;
+            }
+            return false;
+        }
+
+        std::istream& in;
+        const std::string fileName;
+        size_t line;
+        std::deque< Token > tokens;
+    };
+}
+
+// reads the CPLEX LP file of in (fileName for the errors)
+template < typename T >
+LinearProgram< T > ReadLp( std::istream& in, const std::string& fileName )
+{
+    using namespace LpReader;
+    typedef Tokenizer::Token Token;
+    struct Entry { size_t row, column; T value; };
+
+    LinearProgram< T > lp;
+    Builder< T > builder( lp );
+    Tokenizer tokens( in, fileName );
+    std::unordered_map< std::string, size_t > columns;
+    std::vector< Entry > entries;
+
+    auto column = [&]( const std::string& name ) -> size_t
+    {
+        const auto i = columns.find( name );
+        if ( i != columns.end() ) return i->second;
+        const size_t j = builder.AddColumn( name );
+        columns.insert( std::make_pair( name, j ) );
+        return j;
+    };
+    auto isOperator = [&]( size_t k, const char* op )
+    {
+        const Token& t = tokens.Peek( k );
+        return t.kind == Tokenizer::Operator && t.text == op;
+    };
+    // the label "name:" of the objective or of a constraint
+    auto label = [&]() -> std::string
+    {
+        if ( tokens.Peek().kind != Tokenizer::Name || !isOperator( 1, ":" ) ) return std::string();
+        std::string name = tokens.Next().text;
+        tokens.Next();
+        return name;
+    };
+    // [+|-] number
+    auto number = [&]() -> T
+    {
+        T sign = 1;
+        while ( isOperator( 0, "+" ) || isOperator( 0, "-" ) )
+            if ( tokens.Next().text == "-" ) sign = - sign;
+        if ( tokens.Peek().kind != Tokenizer::Number ) throw tokens.Error( "expecting a number" );
+        return sign * static_cast< T >( tokens.Next().number );
+    };
+    // the terms [+|-] [number] name until something else, f( column, coefficient ) for each one;
+    // returns the sum of the constants
+    auto expression = [&]( std::function< void( size_t, T ) > f ) -> T
+    {
+        T constant = 0;
+        for ( ;; )
+        {
+            T sign = 1;
+            bool term = false;
+            while ( isOperator( 0, "+" ) || isOperator( 0, "-" ) )
+            {
+                if ( tokens.Next().text == "-" ) sign = - sign;
+                term = true;
+            }
+            const Token& t = tokens.Peek();
+            if ( t.kind == Tokenizer::Number )
+            {
+                const T value = sign * static_cast< T >( tokens.Next().number );
+                if ( tokens.Peek().kind == Tokenizer::Name && !isOperator( 1, ":" ) )
+                    f( column( tokens.Next().text ), value );
+                else
+                    constant += value;
+            }
+            else if ( t.kind == Tokenizer::Name && !isOperator( 1, ":" ) )
+                f( column( tokens.Next().text ), sign );
+            else if ( term )
+                throw tokens.Error( "expecting a term" );
+            else
+                return constant;
+        }
+    };
+
+    if ( tokens.Peek().kind != Tokenizer::Section ||
+         ( tokens.Peek().section != Tokenizer::Maximize && tokens.Peek().section != Tokenizer::Minimize ) )
+        throw tokens.Error( "expecting Maximize or Minimize" );
+    for ( bool end = false; !end; )
+    {
+        const Token t = tokens.Next();
+        if ( t.kind == Tokenizer::End ) break;
+        if ( t.kind != Tokenizer::Section ) throw tokens.Error( "unexpected " + ( t.text.empty() ? std::string( "number" ) : t.text ) );
+        switch ( t.section )
+        {
+            case Tokenizer::Maximize:
+            case Tokenizer::Minimize:
+                lp.maximize = t.section == Tokenizer::Maximize;
+                label();
+                lp.offset = expression( [&]( size_t j, T value ) { lp.c[ j ] += value; } );
+                break;
+            case Tokenizer::SubjectTo:
+                while ( tokens.Peek().kind != Tokenizer::Section && tokens.Peek().kind != Tokenizer::End )
+                {
+                    std::string name = label();
+                    if ( name.empty() ) name = "c" + std::to_string( builder.Rows() + 1 );
+                    const size_t row = builder.Rows();
+                    const T constant = expression( [&]( size_t j, T value ) { entries.push_back( Entry{ row, j, value } ); } );
+                    const Token op = tokens.Next();
+                    if ( op.kind != Tokenizer::Operator || ( op.text != "<=" && op.text != ">=" && op.text != "=" ) )
+                        throw tokens.Error( "expecting <=, >= or = in the constraint " + name );
+                    builder.AddRow( name, op.text == "<=" ? Less : op.text == ">=" ? Greater : Equal );
+                    lp.b[ row ] = number() - constant;
+                }
+                break;
+            case Tokenizer::BoundsSection:
+                while ( tokens.Peek().kind != Tokenizer::Section && tokens.Peek().kind != Tokenizer::End )
+                {
+                    // x free | x op value | value op x [op value]
+                    if ( tokens.Peek().kind == Tokenizer::Name && tokens.Peek( 1 ).kind == Tokenizer::Name &&
+                         SameText( tokens.Peek( 1 ).text, "free" ) )
+                    {
+                        const size_t j = column( tokens.Next().text );
+                        tokens.Next();
+                        builder.Lower( j ) = - std::numeric_limits< T >::infinity();
+                        builder.Upper( j ) = std::numeric_limits< T >::infinity();
+                        continue;
+                    }
+                    // the bound value op x: flips op for x op value
+                    auto bound = [&]( size_t j, const std::string& op, T value )
+                    {
+                        if ( op != ">=" ) builder.Upper( j ) = value;
+                        if ( op != "<=" ) builder.Lower( j ) = value;
+                    };
+                    auto flip = []( const std::string& op ) { return op == "<=" ? std::string( ">=" ) : op == ">=" ? std::string( "<=" ) : op; };
+                    auto relation = [&]() -> std::string
+                    {
+                        const Token op = tokens.Next();
+                        if ( op.kind != Tokenizer::Operator || ( op.text != "<=" && op.text != ">=" && op.text != "=" ) )
+                            throw tokens.Error( "expecting <=, >= or = in the bounds" );
+                        return op.text;
+                    };
+                    if ( tokens.Peek().kind == Tokenizer::Name )
+                    {
+                        const size_t j = column( tokens.Next().text );
+                        const std::string op = relation();
+                        bound( j, op, number() );
+                    }
+                    else
+                    {
+                        const T value = number();
+                        const std::string op = relation();
+                        if ( tokens.Peek().kind != Tokenizer::Name ) throw tokens.Error( "expecting a column in the bounds" );
+                        const size_t j = column( tokens.Next().text );
+                        bound( j, flip( op ), value );
+                        if ( tokens.Peek().kind == Tokenizer::Operator && tokens.Peek().text != "+" && tokens.Peek().text != "-" )
+                        {
+                            const std::string op2 = relation();
+                            bound( j, op2, number() );
+                        }
+                    }
+                }
+                break;
+            case Tokenizer::General:
+            case Tokenizer::Binary:
+                // the integer columns: their relaxation
+                while ( tokens.Peek().kind == Tokenizer::Name )
+                {
+                    const size_t j = column( tokens.Next().text );
+                    if ( t.section == Tokenizer::Binary ) { builder.Lower( j ) = 0; builder.Upper( j ) = 1; }
+                }
+                break;
+            case Tokenizer::EndSection:
+                end = true;
+                break;
+        }
+    }
+
+    // the entries by column: the rows stay in order
+    const size_t n = lp.columnNames.size();
+    std::vector< size_t > start( n + 1, 0 );
+    for ( const Entry& e : entries ) ++start[ e.column + 1 ];
+    for ( size_t j = 0; j < n; ++j ) start[ j + 1 ] += start[ j ];
+    std::vector< size_t > rows( entries.size() );
+    std::vector< T > values( entries.size() );
+    {
+        std::vector< size_t > next( start.begin(), start.end() - 1 );
+        for ( const Entry& e : entries )
+        {
+            rows[ next[ e.column ] ] = e.row;
+            values[ next[ e.column ]++ ] = e.value;
+        }
+        std::vector< Entry >().swap( entries );
+    }
+    lp.a = SparseMatrix< T >( builder.Rows() );
+    lp.a.Reserve( n + builder.Rows(), values.size() + builder.Rows() );
+    for ( size_t j = 0; j < n; ++j )
+    {
+        // a column repeated in a row: the sum
+        for ( size_t k = start[ j ]; k < start[ j + 1 ]; ++k )
+        {
+            T value = values[ k ];
+            while ( k + 1 < start[ j + 1 ] && rows[ k + 1 ] == rows[ k ] ) value += values[ ++k ];
+            lp.a.AddEntry( rows[ k ], value );
+        }
+        lp.a.EndColumn();
+    }
+    size_t j;
+    if ( !builder.Finish( j ) )
+        throw std::runtime_error( fileName + ": column " + lp.columnNames[ j ] + ": upper bound without lower bound is not supported" );
+    return lp;
+}
+
+// reads a .mps or .lp file
+template < typename T >
+LinearProgram< T > ReadProblem( const std::string& fileName )
+{
+    std::ifstream in( fileName );
+    if ( !in ) throw std::runtime_error( "Can't open " + fileName );
+    const size_t dot = fileName.rfind( '.' );
+    std::string extension = dot == std::string::npos ? std::string() : fileName.substr( dot + 1 );
+    if ( LpReader::SameText( extension, "mps" ) ) return ReadMps< T >( in, fileName );
+    if ( LpReader::SameText( extension, "lp" ) ) return ReadLp< T >( in, fileName );
+    throw std::runtime_error( fileName + ": expecting a .mps or .lp file" );
+}
+
+#endif // LP_READER_H_
@@ -28,162 +28,221 @@
  ******************************************************************************/
 
 #include <iostream>
-#include <valarray>
-#include <limits>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <cstdlib>
+#include <stdexcept>
 #include <cassert>
+#include "tableau.h"
+#include "sparse_matrix.h"
+#include "revised_simplex.h"
+#include "lp_reader.h"
 
-template < typename T >
-class Table
+/*
+A random sparse problem with the structure of a production plan:
+maximize the profit of columns products, each one using a few of the rows
+resources (at most the capacity of the resource), and a fifth of the resources
+with a small minimum use instead, so that the phase 1 is needed.
+minimize:
+    c x, c < 0
+subject to:
+    A x + s = b  (capacity)
+    A x - s = b  (minimum use)
+    x, s >= 0
+*/
+void RandomProblem( size_t rows, size_t columns, unsigned seed,
+                    SparseMatrix< double >& a, std::vector< double >& b, std::vector< double >& c )
 {
-public:
-    Table( size_t rows, size_t cols ) : 
-        row_num( rows ),
-        col_num( cols ),
-        data( rows * cols )
-    {}
-    T& operator()( size_t row, size_t column )
+    std::mt19937 rng( seed );
+    std::uniform_real_distribution< double > value( 1, 10 );
+    const size_t perColumn = 4;
+    std::vector< bool > minimum( rows );
+    for ( size_t i = 0; i < rows; ++i )
+        minimum[ i ] = rng() % 5 == 0 && i > 0; // the first resource has a capacity
+    // each product uses at least a resource with a capacity, so the problem is bounded
+    std::vector< std::vector< size_t > > entries( columns );
+    std::vector< size_t > rowCount( rows, 0 );
+    for ( size_t j = 0; j < columns; ++j )
     {
-        assert( row < row_num );
-        assert( column < col_num );
-        // column major
-        return data[ column + row * col_num ];
+        size_t first;
+        do first = rng() % rows; while ( minimum[ first ] );
+        entries[ j ].push_back( first );
+        for ( size_t k = 1; k < perColumn; ++k )
+            entries[ j ].push_back( rng() % rows );
+        std::sort( entries[ j ].begin(), entries[ j ].end() );
+        entries[ j ].erase( std::unique( entries[ j ].begin(), entries[ j ].end() ), entries[ j ].end() );
+        for ( size_t r : entries[ j ] ) ++rowCount[ r ];
     }
-    T operator()( size_t row, size_t column ) const
+    b.resize( rows );
+    for ( size_t i = 0; i < rows; ++i )
     {
-        assert( row < row_num );
-        assert( column < col_num );
-        // column major
-        return data[ column + row * col_num ];
+        minimum[ i ] = minimum[ i ] && rowCount[ i ] > 0;
+        b[ i ] = minimum[ i ] ? value( rng ) / 10 : 50 * value( rng );
     }
-    T& Value( size_t row, size_t col ) { return operator()( row, col ); }
-    T Value( size_t row, size_t col ) const { return operator()( row, col ); }
-    size_t Columns() const { return col_num; }
-    size_t Rows() const { return row_num; }
-    void Print() const
+
+    a = SparseMatrix< double >( rows );
+    a.Reserve( columns + rows, columns * perColumn + rows );
+    c.clear();
+    for ( size_t j = 0; j < columns; ++j )
     {
-        for ( size_t i = 0; i < data.size(); ++i )
-        {
-            if ( i % col_num == 0 && col_num != 0 ) std::cout << "\n";
-            std::cout << data[ i ] << "\t";
-        }
+        for ( size_t r : entries[ j ] )
+            a.AddEntry( r, value( rng ) );
+        a.EndColumn();
+        c.push_back( -value( rng ) );
     }
-private:
-    const size_t row_num;
-    const size_t col_num;
-    typedef std::valarray< T > Data;
-    Data data;
-};
-
-template < typename T >
-class Matrix : public Table< T >
-{
-public:
-    Matrix( size_t rows, size_t cols ) : Table< T >( rows, cols ) {}
-    void DivideRow( size_t row, T d )
+    for ( size_t i = 0; i < rows; ++i )
     {
-        assert( row < Rows() );
-        for ( size_t c = 0; c < Columns(); ++c )
-            Value( row, c ) /= d;
+        a.AddEntry( i, minimum[ i ] ? -1 : 1 );
+        a.EndColumn();
+        c.push_back( 0 );
     }
-    void Linear( size_t r, size_t pivRow, T coeff )
+}
+
+const char* StatusName( RevisedSimplex< double >::Status status )
+{
+    switch ( status )
     {
-        assert( r < Rows() );
-        assert( pivRow  < Rows() );
-        for ( size_t c = 0; c < Columns(); ++c )
-            Value( r, c ) += Value( pivRow, c )* coeff;
+        case RevisedSimplex< double >::Optimal: return "optimal";
+        case RevisedSimplex< double >::Infeasible: return "infeasible";
+        case RevisedSimplex< double >::Unbounded: return "unbounded";
+        case RevisedSimplex< double >::IterationLimit: return "iteration limit";
+        case RevisedSimplex< double >::Singular: return "singular basis";
     }
-};
+    return "";
+}
 
-/*
-Minimize
-    c x
-Subject to
-    A x = b, x_i >= 0
-    
-Canonical Tableau:
-    1   -tr(c)  0
-    0   A       b
-    
-Algorithm:
-    Prendere un valore della prima riga positivo (se non  positivo: fine)
-    Trovare la riga per cui  minimo il rapporto tra il valore dell'ultima colonna e il valore della colonna scelta
-    Il pivot  l'incrocio tra riga e colonna scelta
-    Dividere la riga scelta per il pivot
-    Far diventare 0 ogni valore della colonna scelta tranne il pivot (con combinazioni lineari)
-    Ripetere finch c' almeno un valore negativo nella prima riga
-*/
-template < typename T >
-class SimplexTableau : public Matrix< T >
+// simplex --random ROWS COLUMNS [SEED]: solves a random sparse problem with the revised simplex
+int SolveRandom( size_t rows, size_t columns, unsigned seed )
 {
-public:
-    SimplexTableau( size_t rows, size_t cols ) : Matrix< T >( rows, cols ) {}
-    void SetRow( size_t row_index, const T row[] )
+    using namespace std;
+
+    SparseMatrix< double > a;
+    vector< double > b, c;
+    RandomProblem( rows, columns, seed, a, b, c );
+    cout << rows << " rows, " << a.Columns() << " columns, " << a.NonZeros() << " nonzeros" << endl;
+
+    const auto start = chrono::steady_clock::now();
+    RevisedSimplex< double > rs( std::move( a ), std::move( b ), std::move( c ) );
+    const auto status = rs.Solve( 100 * ( rows + columns ) );
+    const chrono::duration< double, milli > elapsed = chrono::steady_clock::now() - start;
+
+    cout << StatusName( status ) << ", objective " << rs.Objective() << endl;
+    cout << rs.Iterations() << " iterations, " << rs.Refactorizations() << " refactorizations, "
+         << elapsed.count() << " ms (" << elapsed.count() / max< size_t >( rs.Iterations(), 1 ) << " ms per iteration)" << endl;
+    return status == RevisedSimplex< double >::Optimal ? 0 : 1;
+}
+
+// simplex --dense ROWS COLUMNS [THREADS]: solves a random dense problem with the tableau,
+// in the serial mode and on THREADS threads (0: one for each core), and compares them
+int SolveDense( size_t rows, size_t columns, size_t threads )
+{
+    using namespace std;
+
+    // maximize c x subject to A x <= b: the tableau has the slack columns and the Z column
+    const size_t cols = 1 + columns + rows + 1;
+    vector< double > row( cols );
+    mt19937 rng( 1 );
+    uniform_real_distribution< double > value( 1, 10 );
+    auto fill = [&]( SimplexTableau< double >& st )
     {
-        assert( row_index < Rows() );
-        for ( size_t i = 0; i < Columns(); ++i )
-            Value( row_index, i ) = row[ i ];
-    }
-    bool IsValid() const
+        rng.seed( 1 );
+        fill_n( row.begin(), cols, 0.0 );
+        row[ 0 ] = 1;
+        for ( size_t j = 1; j <= columns; ++j ) row[ j ] = value( rng );
+        st.SetRow( 0, &row[ 0 ] );
+        for ( size_t i = 1; i <= rows; ++i )
+        {
+            fill_n( row.begin(), cols, 0.0 );
+            for ( size_t j = 1; j <= columns; ++j ) row[ j ] = value( rng );
+            row[ columns + i ] = 1;
+            row[ cols - 1 ] = 100 * value( rng );
+            st.SetRow( i, &row[ 0 ] );
+        }
+    };
+    const size_t maxIter = 10 * ( rows + columns );
+    auto solve = [&]( SimplexTableau< double >& st, size_t t ) -> double
+    {
+        fill( st );
+        st.SetVerbose( false );
+        st.SetThreads( t );
+        const auto start = chrono::steady_clock::now();
+        st.Solve( maxIter );
+        const chrono::duration< double, milli > elapsed = chrono::steady_clock::now() - start;
+        cout << st.Threads() << ( st.Threads() == 1 ? " thread: " : " threads: " ) << elapsed.count()
+             << " ms, Z = " << - st.Value( 0, cols - 1 ) << endl;
+        return elapsed.count();
+    };
+
+    cout << rows + 1 << " x " << cols << " tableau" << endl;
+    SimplexTableau< double > serial( rows + 1, cols ), parallel( rows + 1, cols );
+    const double serialMs = solve( serial, 1 );
+    const double parallelMs = solve( parallel, threads );
+    bool same = true;
+    for ( size_t r = 0; r <= rows; ++r )
+        same = same && equal( serial.Row( r ), serial.Row( r ) + cols, parallel.Row( r ) );
+    cout << "speedup " << serialMs / parallelMs << ", " << ( same ? "same tableau" : "DIFFERENT TABLEAU" ) << endl;
+    return same ? 0 : 1;
+}
+
+// simplex --read FILE: solves the problem of a free MPS (.mps) or CPLEX LP (.lp) file with the revised simplex
+int SolveFile( const std::string& fileName )
+{
+    using namespace std;
+
+    auto start = chrono::steady_clock::now();
+    LinearProgram< double > lp;
+    try
     {
-        return true;
+        lp = ReadProblem< double >( fileName );
     }
-    void Solve( size_t maxIter )
+    catch ( const exception& e )
     {
-        for ( size_t count = 0; count < maxIter; ++count )
-        {
-            // find pivot column:
-            int pivCol = FindPivotColumn();
-
-            if ( pivCol == -1 ) return;
-            assert( pivCol >= 0 && pivCol < Columns() );
-
-            size_t pivRow = 0;
-            
-            // find minimum ratio
-            double minRatio = std::numeric_limits< double >::max();
-            for ( size_t r = 1; r < Rows(); ++r )
-            {
-                if ( Value( r, pivCol ) == 0 ) continue;
-                double ratio = Value( r, Columns() - 1 ) / Value( r, pivCol );
-                if ( ratio < minRatio )
-                {
-                    minRatio = ratio;
-                    pivRow = r;
-                }
-            }
-            assert( pivRow < Rows() );
-
-            // divide pivot row for pivot value
-            DivideRow( pivRow, Value( pivRow, pivCol ) );
-            
-            // scale other rows
-            for ( size_t r = 0; r < Rows(); ++r )
-            {
-                if ( r != pivRow )
-                {
-                    const T coeff = - Value( r, pivCol );
-                    Linear( r, pivRow, coeff );
-                }
-            }
-            
-            Print();
-            std::cout << std::endl;
-        }
+        cerr << e.what() << endl;
+        return 1;
     }
-private:
-    // returns -1 if no negative value found
-    int FindPivotColumn() const
+    const chrono::duration< double, milli > loading = chrono::steady_clock::now() - start;
+    cout << fileName << ": " << lp.a.Rows() << " rows, " << lp.a.Columns() << " columns ("
+         << lp.slacks << " slack and surplus), " << lp.a.NonZeros() << " nonzeros, loaded in " << loading.count() << " ms" << endl;
+
+    start = chrono::steady_clock::now();
+    const size_t maxIter = 100 * ( lp.a.Rows() + lp.a.Columns() );
+    RevisedSimplex< double > rs( std::move( lp.a ), std::move( lp.b ), std::move( lp.c ) ); // lp keeps only the names and the bounds
+    const auto status = rs.Solve( maxIter );
+    const chrono::duration< double, milli > solving = chrono::steady_clock::now() - start;
+
+    cout << StatusName( status ) << ", objective " << lp.Objective( rs.Objective() ) << endl;
+    cout << rs.Iterations() << " iterations, " << solving.count() << " ms" << endl;
+    if ( status == RevisedSimplex< double >::Optimal && lp.structurals <= 20 )
     {
-        for ( size_t i = 1; i < Columns(); ++i )
-            if ( Value( 0, i ) > 0 ) return i;
-        return -1;
+        const vector< double > x = lp.Solution( rs.Solution() );
+        for ( size_t j = 0; j < lp.structurals; ++j )
+            cout << lp.columnNames[ j ] << " = " << x[ j ] << endl;
     }
-};
+    return status == RevisedSimplex< double >::Optimal ? 0 : 1;
+}
 
-int main()
+int main( int argc, char* argv[] )
 {
     using namespace std;
 
+    if ( argc >= 2 && string( argv[ 1 ] ) == "--random" )
+    {
+        const int rows = argc >= 4 ? atoi( argv[ 2 ] ) : 0, columns = argc >= 4 ? atoi( argv[ 3 ] ) : 0;
+        if ( rows <= 0 || columns <= 0 )
+        {
+            cerr << "Usage: simplex --random ROWS COLUMNS [SEED], with ROWS and COLUMNS positive" << endl;
+            return 1;
+        }
+        return SolveRandom( rows, columns, argc > 4 ? atoi( argv[ 4 ] ) : 1 );
+    }
+    if ( argc >= 3 && string( argv[ 1 ] ) == "--read" )
+        return SolveFile( argv[ 2 ] );
+    if ( argc >= 4 && string( argv[ 1 ] ) == "--dense" )
+        return SolveDense( atoi( argv[ 2 ] ), atoi( argv[ 3 ] ), argc > 4 ? atoi( argv[ 4 ] ) : 0 );
+
     /*
     example
     minimize:
@@ -213,6 +272,23 @@ int main()
     st.Solve( 10 );
     
     st.Print();
-    
+    cout << endl;
+
+    // the same problem with the revised simplex (the Z column is implicit)
+    SparseMatrix< double > a( 2 );
+    const size_t rows[] = { 0, 1 };
+    const double x[] = { 3, 2 }, y[] = { 2, 5 }, z[] = { 1, 3 }, s1[] = { 1, 0 }, s2[] = { 0, 1 };
+    a.AddColumn( rows, x, 2 );
+    a.AddColumn( rows, y, 2 );
+    a.AddColumn( rows, z, 2 );
+    a.AddColumn( rows, s1, 2 );
+    a.AddColumn( rows, s2, 2 );
+    const double b[] = { 10, 15 }, c[] = { -2, -3, -4, 0, 0 };
+    RevisedSimplex< double > rs( a, vector< double >( b, b + 2 ), vector< double >( c, c + 5 ) );
+    cout << "Revised simplex: " << StatusName( rs.Solve( 10 ) ) << ", Z = " << rs.Objective() << ", x =";
+    for ( double v : rs.Solution() )
+        cout << ' ' << v;
+    cout << endl;
+
     return 0;
 }
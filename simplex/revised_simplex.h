@@ -0,0 +1,253 @@
+/*******************************************************************************
+ * SIMPLEX - A simplex algorithm implementation.
+ * Copyright (C) 2013 Daniele Pallastrelli
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+#ifndef REVISED_SIMPLEX_H_
+#define REVISED_SIMPLEX_H_
+
+#include <vector>
+#include <cmath>
+#include <limits>
+#include <cassert>
+#include <utility>
+#include "sparse_matrix.h"
+#include "basis_factor.h"
+
+/*
+Revised simplex:
+Minimize
+    c x
+Subject to
+    A x = b, x_i >= 0
+with A sparse (slack and surplus columns already added).
+
+Unlike SimplexTableau, only the basis is kept, as the LU factorization of
+BasisFactor: an iteration costs a BTRAN (the prices y = c_B B^-1), the reduced
+costs c_j - y A_j of the columns not in the basis (one pass over the nonzeros of A),
+a FTRAN of the entering column and the ratio test, so the work and the memory
+grow with the nonzeros and not with the rows * the columns.
+
+The starting basis takes a column with a single positive entry for each row,
+when there is one (the slack columns), and an artificial column for the others:
+then the phase 1 minimizes the sum of the artificials. In the phase 2 the
+artificials left in the basis (at 0) leave it as soon as possible and never
+come back.
+*/
+template < typename T >
+class RevisedSimplex
+{
+public:
+    enum Status { Optimal, Infeasible, Unbounded, IterationLimit, Singular };
+
+    // the problem is taken by value: move it in, so that A is not copied
+    RevisedSimplex( SparseMatrix< T > _a, std::vector< T > _b, std::vector< T > _c ) :
+        a( std::move( _a ) ), b( std::move( _b ) ), c( std::move( _c ) ),
+        m( a.Rows() ), n( a.Columns() ),
+        iterations( 0 ), refactorizations( 0 ),
+        tolerance( 1e-9 ), pivot_tolerance( 1e-7 )
+    {
+        assert( b.size() == m && c.size() == n );
+    }
+
+    size_t Iterations() const { return iterations; }
+    size_t Refactorizations() const { return refactorizations; }
+    void SetRefactorPeriod( size_t period ) { factor.SetRefactorPeriod( period ); }
+
+    Status Solve( size_t maxIter )
+    {
+        iterations = 0;
+        refactorizations = 0;
+        if ( basis.empty() ) StartingBasis();
+        if ( a.Columns() > n ) // phase 1
+        {
+            std::vector< T > cost( a.Columns(), 0 );
+            for ( size_t j = n; j < a.Columns(); ++j ) cost[ j ] = 1;
+            const Status status = Iterate( cost, maxIter, true );
+            if ( status != Optimal ) return status == Unbounded ? Singular : status; // phase 1 is bounded
+            T infeasibility = 0, scale = 1;
+            for ( size_t i = 0; i < m; ++i )
+            {
+                if ( basis[ i ] >= n ) infeasibility += x_basic[ i ];
+                scale = std::max( scale, std::abs( b[ i ] ) );
+            }
+            if ( infeasibility > 1e-7 * scale ) return Infeasible;
+        }
+        std::vector< T > cost( c );
+        cost.resize( a.Columns(), 0 );
+        return Iterate( cost, maxIter, false );
+    }
+
+    // c x of the current basis
+    T Objective() const
+    {
+        T z = 0;
+        for ( size_t i = 0; i < m; ++i )
+            if ( basis[ i ] < n ) z += c[ basis[ i ] ] * x_basic[ i ];
+        return z;
+    }
+    // the values of the original columns
+    std::vector< T > Solution() const
+    {
+        std::vector< T > x( n, 0 );
+        for ( size_t i = 0; i < m; ++i )
+            if ( basis[ i ] < n ) x[ basis[ i ] ] = x_basic[ i ];
+        return x;
+    }
+private:
+    void StartingBasis()
+    {
+        // b >= 0: the rows with b < 0 change sign
+        std::vector< bool > negative( m, false );
+        for ( size_t i = 0; i < m; ++i )
+        {
+            if ( b[ i ] < 0 )
+            {
+                negative[ i ] = true;
+                b[ i ] = -b[ i ];
+            }
+        }
+        for ( size_t k = 0; k < a.NonZeros(); ++k )
+            if ( negative[ a.RowIndex( k ) ] ) a.Value( k ) = -a.Value( k );
+
+        const size_t none = std::numeric_limits< size_t >::max();
+        basis.assign( m, none );
+        for ( size_t j = 0; j < n; ++j )
+        {
+            if ( a.ColumnCount( j ) != 1 ) continue;
+            const size_t k = a.ColumnBegin( j );
+            if ( a.Value( k ) > 0 && basis[ a.RowIndex( k ) ] == none )
+                basis[ a.RowIndex( k ) ] = j;
+        }
+        for ( size_t i = 0; i < m; ++i )
+        {
+            if ( basis[ i ] == none )
+            {
+                a.AddEntry( i, 1 );
+                basis[ i ] = a.EndColumn();
+            }
+        }
+        in_basis.assign( a.Columns(), false );
+        for ( size_t i = 0; i < m; ++i ) in_basis[ basis[ i ] ] = true;
+    }
+
+    bool Refactor()
+    {
+        ++refactorizations;
+        if ( !factor.Factorize( a, basis ) ) return false;
+        x_basic = b;
+        factor.Ftran( x_basic );
+        for ( size_t i = 0; i < m; ++i )
+            if ( x_basic[ i ] < 0 ) x_basic[ i ] = 0; // rounding
+        return true;
+    }
+
+    Status Iterate( const std::vector< T >& cost, size_t maxIter, bool phase1 )
+    {
+        if ( !Refactor() ) return Singular;
+        std::vector< T > y( m ), alpha( m );
+        for ( ; iterations < maxIter; ++iterations )
+        {
+            if ( factor.NeedsRefactor() && !Refactor() ) return Singular;
+
+            // prices
+            for ( size_t i = 0; i < m; ++i ) y[ i ] = cost[ basis[ i ] ];
+            factor.Btran( y );
+
+            // entering column: the most negative reduced cost (Dantzig)
+            size_t entering = a.Columns();
+            T best = -tolerance;
+            for ( size_t j = 0; j < a.Columns(); ++j )
+            {
+                if ( in_basis[ j ] || ( j >= n && !phase1 ) ) continue;
+                const T d = cost[ j ] - a.Dot( j, y );
+                if ( d < best )
+                {
+                    best = d;
+                    entering = j;
+                }
+            }
+            if ( entering == a.Columns() ) return Optimal;
+
+            std::fill( alpha.begin(), alpha.end(), T( 0 ) );
+            a.AddTo( entering, 1, alpha );
+            factor.Ftran( alpha );
+
+            // leaving row: minimum ratio, the largest pivot among the ties
+            size_t leaving = m;
+            T minRatio = std::numeric_limits< T >::max();
+            T theta = 0;
+            for ( size_t i = 0; i < m; ++i )
+            {
+                T ratio;
+                if ( !phase1 && basis[ i ] >= n && std::abs( alpha[ i ] ) > pivot_tolerance )
+                    ratio = 0; // an artificial at 0 leaves
+                else if ( alpha[ i ] > pivot_tolerance )
+                    ratio = x_basic[ i ] / alpha[ i ];
+                else
+                    continue;
+                if ( leaving == m || ratio < minRatio - tolerance ||
+                     ( ratio <= minRatio + tolerance && std::abs( alpha[ i ] ) > std::abs( alpha[ leaving ] ) ) )
+                {
+                    minRatio = std::min( ratio, minRatio );
+                    leaving = i;
+                    theta = ratio;
+                }
+            }
+            if ( leaving == m ) return Unbounded;
+
+            for ( size_t i = 0; i < m; ++i )
+            {
+                x_basic[ i ] -= theta * alpha[ i ];
+                if ( x_basic[ i ] < 0 ) x_basic[ i ] = 0;
+            }
+            x_basic[ leaving ] = theta;
+            in_basis[ basis[ leaving ] ] = false;
+            in_basis[ entering ] = true;
+            basis[ leaving ] = entering;
+            factor.Update( leaving, alpha );
+        }
+        return IterationLimit;
+    }
+
+    SparseMatrix< T > a; // with the artificial columns
+    std::vector< T > b;
+    const std::vector< T > c;
+    const size_t m;
+    const size_t n; // the original columns
+    size_t iterations;
+    size_t refactorizations;
+    const T tolerance;
+    const T pivot_tolerance;
+
+    BasisFactor< T > factor;
+    std::vector< size_t > basis; // the column in each position
+    std::vector< bool > in_basis;
+    std::vector< T > x_basic;
+};
+
+#endif // REVISED_SIMPLEX_H_
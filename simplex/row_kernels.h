@@ -0,0 +1,237 @@
+/*******************************************************************************
+ * SIMPLEX - A simplex algorithm implementation.
+ * Copyright (C) 2013 Daniele Pallastrelli
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+#ifndef ROW_KERNELS_H_
+#define ROW_KERNELS_H_
+
+#include <cstddef>
+
+#if defined( __x86_64__ ) || defined( __i386__ ) || defined( _M_X64 ) || defined( _M_IX86 )
+#define ROW_KERNELS_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// the functions with the instructions of isa (MSVC needs nothing to use the intrinsics)
+#if defined( ROW_KERNELS_X86 ) && !defined( _MSC_VER )
+#define ROW_KERNELS_TARGET( isa ) __attribute__(( target( isa ) ))
+#else
+#define ROW_KERNELS_TARGET( isa )
+#endif
+
+/*
+Kernels on contiguous rows of doubles, the inner loops of the tableau:
+    Axpy:   y += a * x   (Matrix::Linear)
+    Divide: x /= d       (Matrix::DivideRow)
+in AVX-512, AVX2 and plain C++. The instruction set is chosen at run time
+(the best one the cpu and the os support) unless it is forced with Select.
+All the versions make the same operations in the same order (a multiply then
+an add, no FMA, and a real division), so the results are the same bit by bit
+(as long as the compiler doesn't contract the scalar code: no -mfma with
+-ffp-contract=fast, the default of gcc).
+*/
+namespace RowKernels
+{
+    enum Isa { Scalar, Avx2, Avx512 };
+
+    inline const char* Name( Isa isa )
+    {
+        switch ( isa )
+        {
+            case Scalar: return "scalar";
+            case Avx2: return "AVX2";
+            case Avx512: return "AVX-512";
+        }
+        return "";
+    }
+
+    // the best instruction set supported by the cpu and the os
+    inline Isa Detect()
+    {
+#if defined( ROW_KERNELS_X86 ) && defined( _MSC_VER )
+        int info[ 4 ];
+        __cpuid( info, 0 );
+        if ( info[ 0 ] < 7 ) return Scalar;
+        __cpuid( info, 1 );
+        const bool osxsave = ( info[ 2 ] & ( 1 << 27 ) ) != 0;
+        const bool avx = ( info[ 2 ] & ( 1 << 28 ) ) != 0;
+        if ( !osxsave || !avx ) return Scalar;
+        const unsigned long long xcr0 = _xgetbv( 0 );
+        __cpuidex( info, 7, 0 );
+        if ( ( info[ 1 ] & ( 1 << 16 ) ) && ( xcr0 & 0xE6 ) == 0xE6 ) return Avx512; // zmm, ymm and xmm state
+        if ( ( info[ 1 ] & ( 1 << 5 ) ) && ( xcr0 & 0x6 ) == 0x6 ) return Avx2;
+        return Scalar;
+#elif defined( ROW_KERNELS_X86 )
+        __builtin_cpu_init();
+        if ( __builtin_cpu_supports( "avx512f" ) ) return Avx512;
+        if ( __builtin_cpu_supports( "avx2" ) ) return Avx2;
+        return Scalar;
+#else
+        return Scalar;
+#endif
+    }
+
+    inline Isa& Selected()
+    {
+        static Isa isa = Detect();
+        return isa;
+    }
+    // forces isa (for the benchmarks), that must be supported
+    inline void Select( Isa isa ) { Selected() = isa; }
+
+    inline void AxpyScalar( double* y, const double* x, double a, size_t n )
+    {
+        for ( size_t i = 0; i < n; ++i )
+            y[ i ] += x[ i ] * a;
+    }
+    inline void DivideScalar( double* x, double d, size_t n )
+    {
+        for ( size_t i = 0; i < n; ++i )
+            x[ i ] /= d;
+    }
+
+#ifdef ROW_KERNELS_X86
+    ROW_KERNELS_TARGET( "avx2" )
+    inline void AxpyAvx2( double* y, const double* x, double a, size_t n )
+    {
+        const __m256d va = _mm256_set1_pd( a );
+        size_t i = 0;
+        for ( ; i + 8 <= n; i += 8 )
+        {
+            const __m256d y0 = _mm256_add_pd( _mm256_loadu_pd( y + i ), _mm256_mul_pd( _mm256_loadu_pd( x + i ), va ) );
+            const __m256d y1 = _mm256_add_pd( _mm256_loadu_pd( y + i + 4 ), _mm256_mul_pd( _mm256_loadu_pd( x + i + 4 ), va ) );
+            _mm256_storeu_pd( y + i, y0 );
+            _mm256_storeu_pd( y + i + 4, y1 );
+        }
+        for ( ; i + 4 <= n; i += 4 )
+            _mm256_storeu_pd( y + i, _mm256_add_pd( _mm256_loadu_pd( y + i ), _mm256_mul_pd( _mm256_loadu_pd( x + i ), va ) ) );
+        for ( ; i < n; ++i )
+            y[ i ] += x[ i ] * a;
+    }
+    ROW_KERNELS_TARGET( "avx2" )
+    inline void DivideAvx2( double* x, double d, size_t n )
+    {
+        const __m256d vd = _mm256_set1_pd( d );
+        size_t i = 0;
+        for ( ; i + 4 <= n; i += 4 )
+            _mm256_storeu_pd( x + i, _mm256_div_pd( _mm256_loadu_pd( x + i ), vd ) );
+        for ( ; i < n; ++i )
+            x[ i ] /= d;
+    }
+
+    // avx512f implies fma for gcc, that would fuse _mm512_mul_pd and _mm512_add_pd:
+    // the rounding versions are never fused
+    ROW_KERNELS_TARGET( "avx512f" )
+    inline __m512d AxpyAvx512( __m512d y, __m512d x, __m512d a )
+    {
+        const __mmask8 all = 0xFF;
+        return _mm512_maskz_add_round_pd( all, y, _mm512_maskz_mul_round_pd( all, x, a, _MM_FROUND_CUR_DIRECTION ), _MM_FROUND_CUR_DIRECTION );
+    }
+    ROW_KERNELS_TARGET( "avx512f" )
+    inline void AxpyAvx512( double* y, const double* x, double a, size_t n )
+    {
+        const __m512d va = _mm512_set1_pd( a );
+        size_t i = 0;
+        for ( ; i + 16 <= n; i += 16 )
+        {
+            const __m512d y0 = AxpyAvx512( _mm512_loadu_pd( y + i ), _mm512_loadu_pd( x + i ), va );
+            const __m512d y1 = AxpyAvx512( _mm512_loadu_pd( y + i + 8 ), _mm512_loadu_pd( x + i + 8 ), va );
+            _mm512_storeu_pd( y + i, y0 );
+            _mm512_storeu_pd( y + i + 8, y1 );
+        }
+        if ( i < n ) // the tail with a mask
+        {
+            for ( ; i + 8 <= n; i += 8 )
+                _mm512_storeu_pd( y + i, AxpyAvx512( _mm512_loadu_pd( y + i ), _mm512_loadu_pd( x + i ), va ) );
+            const __mmask8 mask = static_cast< __mmask8 >( ( 1u << ( n - i ) ) - 1 );
+            const __m512d yt = _mm512_maskz_loadu_pd( mask, y + i );
+            const __m512d xt = _mm512_maskz_loadu_pd( mask, x + i );
+            _mm512_mask_storeu_pd( y + i, mask, AxpyAvx512( yt, xt, va ) );
+        }
+    }
+    ROW_KERNELS_TARGET( "avx512f" )
+    inline void DivideAvx512( double* x, double d, size_t n )
+    {
+        const __m512d vd = _mm512_set1_pd( d );
+        size_t i = 0;
+        for ( ; i + 8 <= n; i += 8 )
+            _mm512_storeu_pd( x + i, _mm512_div_pd( _mm512_loadu_pd( x + i ), vd ) );
+        if ( i < n )
+        {
+            const __mmask8 mask = static_cast< __mmask8 >( ( 1u << ( n - i ) ) - 1 );
+            _mm512_mask_storeu_pd( x + i, mask, _mm512_div_pd( _mm512_maskz_loadu_pd( mask, x + i ), vd ) );
+        }
+    }
+#endif
+
+    // y[ 0 .. n - 1 ] += a * x[ 0 .. n - 1 ]
+    inline void Axpy( double* y, const double* x, double a, size_t n )
+    {
+#ifdef ROW_KERNELS_X86
+        switch ( Selected() )
+        {
+            case Avx512: AxpyAvx512( y, x, a, n ); return;
+            case Avx2: AxpyAvx2( y, x, a, n ); return;
+            case Scalar: break;
+        }
+#endif
+        AxpyScalar( y, x, a, n );
+    }
+    // x[ 0 .. n - 1 ] /= d
+    inline void Divide( double* x, double d, size_t n )
+    {
+#ifdef ROW_KERNELS_X86
+        switch ( Selected() )
+        {
+            case Avx512: DivideAvx512( x, d, n ); return;
+            case Avx2: DivideAvx2( x, d, n ); return;
+            case Scalar: break;
+        }
+#endif
+        DivideScalar( x, d, n );
+    }
+
+    // the other types use the loops
+    template < typename T >
+    void Axpy( T* y, const T* x, T a, size_t n )
+    {
+        for ( size_t i = 0; i < n; ++i )
+            y[ i ] += x[ i ] * a;
+    }
+    template < typename T >
+    void Divide( T* x, T d, size_t n )
+    {
+        for ( size_t i = 0; i < n; ++i )
+            x[ i ] /= d;
+    }
+}
+
+#endif // ROW_KERNELS_H_
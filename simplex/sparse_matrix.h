@@ -0,0 +1,115 @@
+/*******************************************************************************
+ * SIMPLEX - A simplex algorithm implementation.
+ * Copyright (C) 2013 Daniele Pallastrelli
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+#ifndef SPARSE_MATRIX_H_
+#define SPARSE_MATRIX_H_
+
+#include <vector>
+#include <cassert>
+
+/*
+Sparse matrix in compressed sparse column form (CSC):
+the nonzeros of column j are the positions ColumnBegin( j ) ... ColumnEnd( j ) - 1
+of RowIndex / Value.
+Columns are appended one at a time (AddEntry... then EndColumn), so a problem
+can be streamed in without building a dense copy.
+*/
+template < typename T >
+class SparseMatrix
+{
+public:
+    explicit SparseMatrix( size_t rows = 0 ) : row_num( rows ), col_start( 1, 0 ) {}
+
+    size_t Rows() const { return row_num; }
+    size_t Columns() const { return col_start.size() - 1; }
+    size_t NonZeros() const { return values.size(); }
+
+    // the rows can grow while the columns are added (the new rows are empty)
+    void SetRows( size_t rows )
+    {
+        assert( rows >= row_num );
+        row_num = rows;
+    }
+    void Reserve( size_t columns, size_t nonZeros )
+    {
+        col_start.reserve( columns + 1 );
+        row_index.reserve( nonZeros );
+        values.reserve( nonZeros );
+    }
+
+    // adds an entry to the column being built
+    void AddEntry( size_t row, T value )
+    {
+        assert( row < row_num );
+        if ( value == 0 ) return;
+        row_index.push_back( row );
+        values.push_back( value );
+    }
+    // closes the column being built and returns its index
+    size_t EndColumn()
+    {
+        col_start.push_back( values.size() );
+        return Columns() - 1;
+    }
+    size_t AddColumn( const size_t rows[], const T vals[], size_t count )
+    {
+        for ( size_t k = 0; k < count; ++k )
+            AddEntry( rows[ k ], vals[ k ] );
+        return EndColumn();
+    }
+
+    size_t ColumnBegin( size_t col ) const { assert( col < Columns() ); return col_start[ col ]; }
+    size_t ColumnEnd( size_t col ) const { assert( col < Columns() ); return col_start[ col + 1 ]; }
+    size_t ColumnCount( size_t col ) const { return ColumnEnd( col ) - ColumnBegin( col ); }
+    size_t RowIndex( size_t k ) const { return row_index[ k ]; }
+    T Value( size_t k ) const { return values[ k ]; }
+    T& Value( size_t k ) { return values[ k ]; }
+
+    // y . column
+    T Dot( size_t col, const std::vector< T >& y ) const
+    {
+        T sum = 0;
+        for ( size_t k = ColumnBegin( col ); k < ColumnEnd( col ); ++k )
+            sum += values[ k ] * y[ row_index[ k ] ];
+        return sum;
+    }
+    // x += coeff * column
+    void AddTo( size_t col, T coeff, std::vector< T >& x ) const
+    {
+        for ( size_t k = ColumnBegin( col ); k < ColumnEnd( col ); ++k )
+            x[ row_index[ k ] ] += coeff * values[ k ];
+    }
+private:
+    size_t row_num;
+    std::vector< size_t > col_start; // Columns() + 1 offsets
+    std::vector< size_t > row_index;
+    std::vector< T > values;
+};
+
+#endif // SPARSE_MATRIX_H_
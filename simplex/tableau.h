@@ -0,0 +1,484 @@
+/*******************************************************************************
+ * SIMPLEX - A simplex algorithm implementation.
+ * Copyright (C) 2013 Daniele Pallastrelli
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+#ifndef TABLEAU_H_
+#define TABLEAU_H_
+
+#include <iostream>
+#include <valarray>
+#include <vector>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <algorithm>
+#include <cmath>
+#include <cassert>
+#include "row_kernels.h"
+#include "thread_pool.h"
+
+template < typename T >
+class Table
+{
+public:
+    Table( size_t rows, size_t cols ) : 
+        row_num( rows ),
+        col_num( cols ),
+        data( rows * cols )
+    {}
+    T& operator()( size_t row, size_t column )
+    {
+        assert( row < row_num );
+        assert( column < col_num );
+        // column major
+        return data[ column + row * col_num ];
+    }
+    T operator()( size_t row, size_t column ) const
+    {
+        assert( row < row_num );
+        assert( column < col_num );
+        // column major
+        return data[ column + row * col_num ];
+    }
+    // the row is contiguous: Row( row )[ c ] == Value( row, c )
+    T* Row( size_t row ) { assert( row < row_num ); return &data[ row * col_num ]; }
+    const T* Row( size_t row ) const { assert( row < row_num ); return &data[ row * col_num ]; }
+    T& Value( size_t row, size_t col ) { return operator()( row, col ); }
+    T Value( size_t row, size_t col ) const { return operator()( row, col ); }
+    size_t Columns() const { return col_num; }
+    size_t Rows() const { return row_num; }
+    void Print() const
+    {
+        for ( size_t i = 0; i < data.size(); ++i )
+        {
+            if ( i % col_num == 0 && col_num != 0 ) std::cout << "\n";
+            std::cout << data[ i ] << "\t";
+        }
+    }
+private:
+    const size_t row_num;
+    const size_t col_num;
+    typedef std::valarray< T > Data;
+    Data data;
+};
+
+template < typename T >
+class Matrix : public Table< T >
+{
+public:
+    Matrix( size_t rows, size_t cols ) : Table< T >( rows, cols ) {}
+    void DivideRow( size_t row, T d )
+    {
+        assert( row < Rows() );
+        RowKernels::Divide( Row( row ), d, Columns() );
+    }
+    // row r += coeff * row pivRow
+    void Linear( size_t r, size_t pivRow, T coeff )
+    {
+        assert( r < Rows() );
+        assert( pivRow  < Rows() );
+        RowKernels::Axpy( Row( r ), Row( pivRow ), coeff, Columns() );
+    }
+};
+
+/*
+Minimize
+    c x
+Subject to
+    A x = b, x_i >= 0
+    
+Canonical Tableau:
+    1   -tr(c)  0
+    0   A       b
+    
+Algorithm:
+    Prendere un valore della prima riga positivo (se non  positivo: fine)
+    Trovare la riga per cui  minimo il rapporto tra il valore dell'ultima colonna e il valore della colonna scelta
+    Il pivot  l'incrocio tra riga e colonna scelta
+    Dividere la riga scelta per il pivot
+    Far diventare 0 ogni valore della colonna scelta tranne il pivot (con combinazioni lineari)
+    Ripetere finch c' almeno un valore negativo nella prima riga
+*/
+// How SimplexTableau::Solve chooses the pivot column among the ones with a
+// positive value d_j in the first row:
+//   FirstFit:     the first one
+//   Dantzig:      the largest d_j
+//   Devex:        the largest d_j^2 / w_j, w_j the approximate norms of the
+//                 columns in a reference framework (Forrest and Goldfarb 1992)
+//   SteepestEdge: the largest d_j^2 / (1 + |column j|^2), the exact norms
+//   Partial:      Dantzig in a segment of the columns at a time, going on
+//                 from the segment of the last pivot, for the very wide tableaux
+//   Multiple:     Dantzig among a few candidates chosen by a full scan, until
+//                 none of them is positive any more
+enum class Pricing { FirstFit, Dantzig, Devex, SteepestEdge, Partial, Multiple };
+
+inline const char* PricingName( Pricing pricing )
+{
+    switch ( pricing )
+    {
+        case Pricing::FirstFit: return "first fit";
+        case Pricing::Dantzig: return "Dantzig";
+        case Pricing::Devex: return "Devex";
+        case Pricing::SteepestEdge: return "steepest edge";
+        case Pricing::Partial: return "partial";
+        case Pricing::Multiple: return "multiple";
+    }
+    return "";
+}
+
+template < typename T >
+class SimplexTableau : public Matrix< T >
+{
+public:
+    SimplexTableau( size_t rows, size_t cols ) :
+        Matrix< T >( rows, cols ), verbose( true ), pricing( Pricing::FirstFit ), iterations( 0 ), segment( 0 )
+    {}
+    void SetRow( size_t row_index, const T row[] )
+    {
+        assert( row_index < Rows() );
+        for ( size_t i = 0; i < Columns(); ++i )
+            Value( row_index, i ) = row[ i ];
+    }
+    bool IsValid() const
+    {
+        return true;
+    }
+    // prints the tableau after each pivot (the default)
+    void SetVerbose( bool v ) { verbose = v; }
+    // Solve on threads threads (0: one for each core), 1 (the default) is the serial mode.
+    // The rows are split among the threads, but every cell gets the same
+    // operations in the same order, so the result doesn't depend on the threads.
+    void SetThreads( size_t threads )
+    {
+        if ( threads == 0 ) threads = std::max( 1u, std::thread::hardware_concurrency() );
+        pool.reset( threads > 1 ? new ThreadPool( threads ) : nullptr );
+    }
+    size_t Threads() const { return pool ? pool->Threads() : 1; }
+    void SetPricing( Pricing p ) { pricing = p; }
+    // the pivots of the last Solve
+    size_t Iterations() const { return iterations; }
+
+    void Solve( size_t maxIter )
+    {
+        StartPricing();
+        for ( iterations = 0; iterations < maxIter; ++iterations )
+        {
+            // find pivot column:
+            int pivCol = FindPivotColumn();
+
+            if ( pivCol == -1 ) return;
+            assert( pivCol >= 0 && pivCol < Columns() );
+
+            // find minimum ratio
+            const size_t pivRow = FindPivotRow( pivCol );
+            if ( pivRow == 0 ) return; // unbounded
+
+            // divide pivot row for pivot value
+            DivideRow( pivRow, Value( pivRow, pivCol ) );
+            
+            // scale other rows
+            Eliminate( pivRow, pivCol );
+            UpdateWeights( pivRow, pivCol );
+            
+            if ( verbose )
+            {
+                Print();
+                std::cout << std::endl;
+            }
+        }
+    }
+private:
+    // the cells of a task of the pool: enough work to pay the synchronization
+    static constexpr size_t minTaskCells = 16 * 1024;
+    // the columns updated together in all the rows of a task, so that
+    // the segment of the pivot row stays in the L1 cache (16 KB of doubles)
+    static constexpr size_t blockColumns = 2048;
+    // the candidates of the multiple pricing
+    static constexpr size_t candidateCount = 8;
+
+    // the tasks splitting n items of cost cells each
+    size_t Tasks( size_t n, size_t cost ) const
+    {
+        if ( !pool || n <= 1 ) return 1;
+        const size_t perTask = std::max< size_t >( 1, minTaskCells / std::max< size_t >( cost, 1 ) );
+        return std::max< size_t >( 1, std::min( ( n + perTask - 1 ) / perTask, 4 * pool->Threads() ) );
+    }
+    // calls f( task, begin, end ) for each task of the tasks splitting [ 0, n )
+    template < typename F >
+    void ForRanges( size_t n, size_t tasks, F f )
+    {
+        const size_t size = ( n + tasks - 1 ) / tasks;
+        auto task = [&]( size_t t ) { f( t, std::min( t * size, n ), std::min( ( t + 1 ) * size, n ) ); };
+        if ( tasks == 1 )
+            task( 0 );
+        else
+            pool->Run( tasks, task );
+    }
+
+    // the pricing columns: the first and the last ones are Z and b
+    size_t FirstPriced() const { return 1; }
+    size_t EndPriced() const { return Columns() - 1; }
+
+    void StartPricing()
+    {
+        weights.assign( Columns(), T( 1 ) );
+        if ( pricing == Pricing::SteepestEdge )
+            ColumnNorms();
+        candidates.clear();
+        segment = 0;
+    }
+
+    // the score of the column j for the pricing, 0 if it can't enter
+    T Score( size_t j ) const
+    {
+        const T d = Value( 0, j );
+        if ( d <= 0 ) return 0;
+        switch ( pricing )
+        {
+            case Pricing::Devex:
+            case Pricing::SteepestEdge:
+                return d * d / weights[ j ];
+            default:
+                return d;
+        }
+    }
+
+    // the column with the largest score in [ begin, end ) (the first among the equal ones),
+    // end if none is positive
+    size_t Best( size_t begin, size_t end )
+    {
+        const size_t n = end - begin;
+        const size_t tasks = Tasks( n, 1 );
+        std::vector< std::pair< T, size_t > > best( tasks, std::make_pair( T( 0 ), end ) );
+        ForRanges( n, tasks, [&]( size_t t, size_t b, size_t e )
+        {
+            for ( size_t j = begin + b; j < begin + e; ++j )
+            {
+                const T score = this->Score( j );
+                if ( score > best[ t ].first )
+                    best[ t ] = std::make_pair( score, j );
+            }
+        } );
+        std::pair< T, size_t > result = best[ 0 ];
+        for ( size_t t = 1; t < tasks; ++t )
+            if ( best[ t ].first > result.first ) result = best[ t ];
+        return result.second;
+    }
+
+    // returns -1 if no positive value found
+    int FindPivotColumn()
+    {
+        const size_t begin = FirstPriced(), end = EndPriced();
+        if ( begin >= end ) return -1;
+        size_t col = end;
+        switch ( pricing )
+        {
+            case Pricing::FirstFit:
+                col = FirstPositive( begin, end );
+                break;
+            case Pricing::Dantzig:
+            case Pricing::Devex:
+            case Pricing::SteepestEdge:
+                col = Best( begin, end );
+                break;
+            case Pricing::Partial:
+            {
+                // segments of sqrt( n ) columns, at least 64
+                const size_t n = end - begin;
+                const size_t size = std::max< size_t >( 64, static_cast< size_t >( std::sqrt( double( n ) ) ) );
+                const size_t segments = ( n + size - 1 ) / size;
+                for ( size_t k = 0; k < segments && col == end; ++k )
+                {
+                    const size_t s = ( segment + k ) % segments;
+                    const size_t e = std::min( begin + ( s + 1 ) * size, end );
+                    col = Best( begin + s * size, e );
+                    if ( col == e ) col = end;
+                    else segment = s;
+                }
+                break;
+            }
+            case Pricing::Multiple:
+            {
+                // the best candidate still positive, or new candidates
+                for ( int pass = 0; pass < 2 && col == end; ++pass )
+                {
+                    if ( pass == 1 ) Candidates( begin, end );
+                    T best = 0;
+                    for ( size_t j : candidates )
+                        if ( Score( j ) > best ) { best = Score( j ); col = j; }
+                }
+                if ( col != end )
+                    candidates.erase( std::find( candidates.begin(), candidates.end(), col ) );
+                break;
+            }
+        }
+        return col == end ? -1 : static_cast< int >( col );
+    }
+
+    // the first positive value of each range, then the first of the ranges
+    size_t FirstPositive( size_t begin, size_t end )
+    {
+        const T* objective = Row( 0 );
+        const size_t n = end - begin;
+        const size_t tasks = Tasks( n, 1 );
+        std::vector< size_t > first( tasks, end );
+        ForRanges( n, tasks, [&]( size_t t, size_t b, size_t e )
+        {
+            for ( size_t i = begin + b; i < begin + e; ++i )
+                if ( objective[ i ] > 0 ) { first[ t ] = i; return; }
+        } );
+        for ( size_t t = 0; t < tasks; ++t )
+            if ( first[ t ] != end ) return first[ t ];
+        return end;
+    }
+
+    // the candidateCount columns with the largest positive values
+    void Candidates( size_t begin, size_t end )
+    {
+        candidates.clear();
+        for ( size_t j = begin; j < end; ++j )
+            if ( Value( 0, j ) > 0 ) candidates.push_back( j );
+        auto larger = [this]( size_t x, size_t y )
+        {
+            return this->Value( 0, x ) > this->Value( 0, y ) || ( this->Value( 0, x ) == this->Value( 0, y ) && x < y );
+        };
+        if ( candidates.size() > candidateCount )
+        {
+            std::nth_element( candidates.begin(), candidates.begin() + candidateCount, candidates.end(), larger );
+            candidates.resize( candidateCount );
+        }
+        std::sort( candidates.begin(), candidates.end() );
+    }
+
+    // the row with the minimum ratio between the last column and the positive
+    // values of the pivot column (the first one among the equal ones), 0 if none
+    size_t FindPivotRow( size_t pivCol )
+    {
+        const size_t n = Rows() - 1; // from the row 1
+        const size_t tasks = Tasks( n, 1 );
+        std::vector< std::pair< T, size_t > > best( tasks, std::make_pair( std::numeric_limits< T >::max(), size_t( 0 ) ) );
+        ForRanges( n, tasks, [&]( size_t t, size_t begin, size_t end )
+        {
+            for ( size_t r = begin + 1; r < end + 1; ++r )
+            {
+                const T* row = this->Row( r );
+                if ( row[ pivCol ] <= 0 ) continue;
+                const T ratio = row[ Columns() - 1 ] / row[ pivCol ];
+                if ( ratio < best[ t ].first )
+                    best[ t ] = std::make_pair( ratio, r );
+            }
+        } );
+        std::pair< T, size_t > result = best[ 0 ];
+        for ( size_t t = 1; t < tasks; ++t )
+            if ( best[ t ].first < result.first ) result = best[ t ];
+        return result.second;
+    }
+
+    // row r -= row r [ pivCol ] * row pivRow, for every row but pivRow.
+    // The tasks take ranges of columns, each one in all the rows in order,
+    // so that the steepest edge norms are summed in the same pass.
+    void Eliminate( size_t pivRow, size_t pivCol )
+    {
+        const size_t rows = Rows(), cols = Columns();
+        const T* pivot = Row( pivRow );
+        // the coefficients first: a task changes the pivot column
+        coefficients.resize( rows );
+        for ( size_t r = 0; r < rows; ++r )
+            coefficients[ r ] = r == pivRow ? T( 0 ) : - Value( r, pivCol );
+        const bool norms = pricing == Pricing::SteepestEdge;
+        ForRanges( cols, Tasks( cols, rows ), [&]( size_t, size_t begin, size_t end )
+        {
+            for ( size_t c = begin; c < end; c += blockColumns )
+            {
+                const size_t width = std::min( blockColumns, end - c );
+                if ( norms ) std::fill_n( &weights[ c ], width, T( 1 ) );
+                for ( size_t r = 0; r < rows; ++r )
+                {
+                    T* row = this->Row( r ) + c;
+                    if ( r != pivRow )
+                        RowKernels::Axpy( row, pivot + c, coefficients[ r ], width );
+                    if ( norms && r > 0 )
+                        for ( size_t k = 0; k < width; ++k )
+                            weights[ c + k ] += row[ k ] * row[ k ];
+                }
+            }
+        } );
+    }
+
+    // the weights of the steepest edge: 1 + the squares of the column below the first row
+    void ColumnNorms()
+    {
+        const size_t rows = Rows(), cols = Columns();
+        ForRanges( cols, Tasks( cols, rows ), [&]( size_t, size_t begin, size_t end )
+        {
+            std::fill( weights.begin() + begin, weights.begin() + end, T( 1 ) );
+            for ( size_t r = 1; r < rows; ++r )
+            {
+                const T* row = this->Row( r );
+                for ( size_t c = begin; c < end; ++c )
+                    weights[ c ] += row[ c ] * row[ c ];
+            }
+        } );
+    }
+
+    // Devex: with the pivot row already divided by the pivot (alpha_rj / alpha_rq),
+    // w_j = max( w_j, ( alpha_rj / alpha_rq )^2 w_q ), and the entering column
+    // (basic now) gets 1 again. When the weights grow too much the framework restarts.
+    void UpdateWeights( size_t pivRow, size_t pivCol )
+    {
+        if ( pricing != Pricing::Devex ) return;
+        const T* pivot = Row( pivRow );
+        const T wq = weights[ pivCol ];
+        T largest = 0;
+        for ( size_t j = FirstPriced(); j < EndPriced(); ++j )
+        {
+            if ( pivot[ j ] == 0 ) continue;
+            weights[ j ] = std::max( weights[ j ], pivot[ j ] * pivot[ j ] * wq );
+            largest = std::max( largest, weights[ j ] );
+        }
+        weights[ pivCol ] = 1;
+        if ( largest > 1e6 )
+            std::fill( weights.begin(), weights.end(), T( 1 ) );
+    }
+
+    bool verbose;
+    Pricing pricing;
+    size_t iterations;
+    std::unique_ptr< ThreadPool > pool; // null in the serial mode
+    std::vector< T > coefficients;  // of Eliminate
+    std::vector< T > weights;       // Devex and steepest edge, by column
+    std::vector< size_t > candidates; // multiple pricing
+    size_t segment;                 // partial pricing: the last segment with a pivot
+};
+
+template < typename T > constexpr size_t SimplexTableau< T >::minTaskCells;
+template < typename T > constexpr size_t SimplexTableau< T >::blockColumns;
+template < typename T > constexpr size_t SimplexTableau< T >::candidateCount;
+
+#endif // TABLEAU_H_
@@ -0,0 +1,133 @@
+/*******************************************************************************
+ * SIMPLEX - A simplex algorithm implementation.
+ * Copyright (C) 2013 Daniele Pallastrelli
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+#ifndef THREAD_POOL_H_
+#define THREAD_POOL_H_
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+/*
+A fixed set of threads, started once, that run the tasks 0 ... count - 1
+of each Run (the calling thread works too), taking the next task not started
+yet. Run returns when all the tasks are done, so the threads of the pool are
+idle (waiting on a condition variable) between two calls and no thread is
+created after the constructor.
+*/
+class ThreadPool
+{
+public:
+    // threads in all, the calling one included
+    explicit ThreadPool( size_t threads ) :
+        task( nullptr ), call( nullptr ), count( 0 ), next( 0 ), busy( 0 ), generation( 0 ), stop( false )
+    {
+        for ( size_t i = 1; i < threads; ++i )
+            workers.emplace_back( [this]() { Work(); } );
+    }
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard< std::mutex > lock( mutex );
+            stop = true;
+        }
+        start.notify_all();
+        for ( auto& w : workers ) w.join();
+    }
+    ThreadPool( const ThreadPool& ) = delete;
+    ThreadPool& operator = ( const ThreadPool& ) = delete;
+
+    size_t Threads() const { return workers.size() + 1; }
+
+    // calls f( i ) for i in 0 ... n - 1 on the threads of the pool
+    template < typename F >
+    void Run( size_t n, F& f )
+    {
+        if ( workers.empty() || n <= 1 )
+        {
+            for ( size_t i = 0; i < n; ++i ) f( i );
+            return;
+        }
+        {
+            std::lock_guard< std::mutex > lock( mutex );
+            task = &f;
+            call = &Call< F >;
+            count = n;
+            next = 0;
+            busy = workers.size();
+            ++generation;
+        }
+        start.notify_all();
+        Tasks();
+        std::unique_lock< std::mutex > lock( mutex );
+        done.wait( lock, [this]() { return busy == 0; } );
+        task = nullptr;
+    }
+private:
+    template < typename F >
+    static void Call( void* f, size_t i ) { ( *static_cast< F* >( f ) )( i ); }
+
+    void Tasks()
+    {
+        for ( size_t i = next++; i < count; i = next++ )
+            call( task, i );
+    }
+    void Work()
+    {
+        unsigned long long seen = 0;
+        for ( ;; )
+        {
+            {
+                std::unique_lock< std::mutex > lock( mutex );
+                start.wait( lock, [&]() { return stop || generation != seen; } );
+                if ( stop ) return;
+                seen = generation;
+            }
+            Tasks();
+            std::lock_guard< std::mutex > lock( mutex );
+            if ( --busy == 0 ) done.notify_one();
+        }
+    }
+
+    std::vector< std::thread > workers;
+    std::mutex mutex;
+    std::condition_variable start;
+    std::condition_variable done;
+    void* task;
+    void ( *call )( void*, size_t );
+    size_t count;
+    std::atomic< size_t > next;
+    size_t busy; // the workers still running the tasks
+    unsigned long long generation; // of Run
+    bool stop;
+};
+
+#endif // THREAD_POOL_H_